@@ -0,0 +1,75 @@
+//operator new counter (built into sim_alloc_check by make alloc-check)
+//all the storage of the pipeline is allocated when a simulation is set up, so
+//the simulation loop itself should never touch the heap. with SIM_ALLOC_CHECK
+//the global operator new and new[] count their calls in the calling thread,
+//and a simulation that called them between its setup and its last cycle
+//stops with an error (see simulator.cc). only operator new is replaced, so
+//malloc calls (the simulator makes none, the C library makes its own) are
+//not counted.
+//without SIM_ALLOC_CHECK all of this compiles away
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+
+#ifdef SIM_ALLOC_CHECK
+
+#include <new>
+
+//operator new calls made by this thread so far. per thread, so the simulations of a
+//sweep and the writer and prefetch threads do not count against each other
+static thread_local uint64_t heap_allocations = 0;
+
+void *operator new(size_t size)
+{
+	heap_allocations++;
+	void *p = malloc(size ? size : 1);
+	if(p == NULL)
+		throw std::bad_alloc();
+	return p;
+}
+
+void *operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void *p) noexcept
+{
+	free(p);
+}
+
+void operator delete[](void *p) noexcept
+{
+	free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+	free(p);
+}
+
+void operator delete[](void *p, size_t) noexcept
+{
+	free(p);
+}
+
+uint64_t get_heap_allocations()
+{
+	return heap_allocations;
+}
+
+//stops the run if the simulation loop allocated
+//at_setup is get_heap_allocations() right after the setup
+void check_heap_allocations(uint64_t at_setup, uint64_t cycles)
+{
+	uint64_t in_loop = heap_allocations - at_setup;
+	fprintf(stderr, "# operator new calls in %" PRIu64 " simulated cycles: %" PRIu64 "\n", cycles, in_loop);
+	if(in_loop != 0)
+	{
+		printf("Error: The simulation loop called operator new %" PRIu64 " times\n", in_loop);
+		exit(EXIT_FAILURE);
+	}
+}
+
+#endif
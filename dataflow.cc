@@ -0,0 +1,105 @@
+//dataflow limit analysis (--dataflow)
+//walks the trace once and schedules every instruction as soon as its sources
+//are ready, using the execution latencies of instruction::calculate_latency().
+//1. infinite machine: no limit on width, ROB or IQ. the cycles are the length
+//   of the critical path through the register dependences
+//2. width limited: at most WIDTH instructions enter per cycle (in order) and at
+//   most WIDTH retire per cycle (in order), no ROB or IQ limit
+//both are upper bounds on the IPC of the detailed pipeline, found in O(N)
+#include <stdio.h>
+#include <stdint.h>
+#include <inttypes.h>
+
+#include <vector>
+
+#include "sim_proc.h"
+
+//registers a trace can name (int8 in the trace record)
+#define DATAFLOW_NUM_REGS 128
+
+typedef struct dataflow_result{
+	uint64_t instructions;
+	//cycles of the infinite machine (critical path length)
+	uint64_t critical_path;
+	//cycles of the width limited machine
+	uint64_t width_cycles;
+}dataflow_result;
+
+void run_dataflow_analysis(trace_reader *trace, unsigned long width, dataflow_result *result)
+{
+	//latency of every op type, straight from the instruction model
+	uint64_t latency[3];
+	for(int op = 0; op < 3; op++)
+	{
+		instruction instr;
+		instr.instruction_initialize(op, -1, -1, -1);
+		instr.calculate_latency();
+		latency[op] = instr.get_execution_latency();
+	}
+
+	//cycle in which every register's latest value is ready, for both machines
+	uint64_t ready_inf[DATAFLOW_NUM_REGS] = {0};
+	uint64_t ready_width[DATAFLOW_NUM_REGS] = {0};
+	//retire cycles of the last WIDTH instructions (ring), for the retire width
+	std::vector<uint64_t> retire_ring(width, 0);
+	uint64_t last_retire = 0;
+
+	result->instructions = 0;
+	result->critical_path = 0;
+	result->width_cycles = 0;
+
+	trace_record recs[1024];
+	unsigned int n;
+	while((n = trace->read_instrs(recs, 1024)) != 0)
+	{
+		for(unsigned int k = 0; k < n; k++)
+		{
+			trace_record& rec = recs[k];
+			uint64_t seq = result->instructions++;
+			uint64_t lat = latency[(rec.op_type >= 0 && rec.op_type < 3) ? rec.op_type : 0];
+
+			//infinite machine
+			uint64_t start = 0;
+			if(rec.src1 >= 0 && ready_inf[rec.src1] > start)
+				start = ready_inf[rec.src1];
+			if(rec.src2 >= 0 && ready_inf[rec.src2] > start)
+				start = ready_inf[rec.src2];
+			uint64_t done = start + lat;
+			if(rec.dst >= 0)
+				ready_inf[rec.dst] = done;
+			if(done > result->critical_path)
+				result->critical_path = done;
+
+			//width limited machine: WIDTH instructions enter per cycle
+			start = seq / width;
+			if(rec.src1 >= 0 && ready_width[rec.src1] > start)
+				start = ready_width[rec.src1];
+			if(rec.src2 >= 0 && ready_width[rec.src2] > start)
+				start = ready_width[rec.src2];
+			done = start + lat;
+			if(rec.dst >= 0)
+				ready_width[rec.dst] = done;
+			//in order retire, at most WIDTH per cycle: not before the previous
+			//instruction and a cycle after the one WIDTH instructions back
+			uint64_t retire = done;
+			if(last_retire > retire)
+				retire = last_retire;
+			uint64_t& width_back = retire_ring[seq % width];
+			if(seq >= width && width_back + 1 > retire)
+				retire = width_back + 1;
+			width_back = retire;
+			last_retire = retire;
+		}
+	}
+	result->width_cycles = last_retire;
+}
+
+void print_dataflow_result(dataflow_result *result)
+{
+	printf("# === Dataflow Limits ===========\n");
+	printf("# Dynamic Instruction Count    = %" PRIu64 "\n", result->instructions);
+	printf("# Critical Path (cycles)       = %" PRIu64 "\n", result->critical_path);
+	printf("# Ideal IPC (infinite machine) = %.2lf\n", result->critical_path ? (double) result->instructions / result->critical_path : 0.0);
+	printf("# Width Limited Cycles         = %" PRIu64 "\n", result->width_cycles);
+	printf("# Width Limited IPC            = %.2lf\n", result->width_cycles ? (double) result->instructions / result->width_cycles : 0.0);
+}
@@ -1,7 +1,10 @@
 #include "sim_proc.h"
+#include "timing_log.h"
 
 #include <vector>
 #include <stdio.h>
+#include <stdint.h>
+#include <inttypes.h>
 #include <iostream>
 
 using namespace std;
@@ -9,56 +12,52 @@ using namespace std;
 //emulates an instruction entry in the pipeline
 //contains data for an instruction
 //1. sequence number (age of the instruction)
-//2. pc
-//3. current stage
-//4. cycles in a given stage
-//   -> also the cycle at which the instruction was fetched
-//5. src1
-//6. src2
-//7. dst
-//8. operation type (0,1,2)
-//9. execution latency (defined via op type)
-//10. ROB index
-//11. the index of instruction for a super scalar width
+//2. the cycle at which the instruction was fetched
+//3. the cycle every stage was entered, relative to the fetch cycle
+//4. rob index and the rob tags of the sources
+//5. src1, src2 and dst
+//6. operation type (0,1,2) and execution latency (defined via op type)
+//7. current stage and the readiness of the sources in the rob
+//
+//a record is exactly 64 bytes (one cache line). registers fit in a byte like in
+//the trace, rob tags in 16 bits (ROB_SIZE <= INSTR_MAX_ROB_SIZE) and the stage and
+//the flags share the last byte
+//
+//the stages only stamp the cycle in which an instruction moves on, so a stalled
+//instruction costs nothing per cycle. the durations are the differences of the
+//stamps and are only worked out when the instruction is printed
+#define INSTR_MAX_ROB_SIZE 32767
+
 class instruction
 {
     private:
-        unsigned int sequence;
-        unsigned long pc;
-        unsigned int current_stage;
-        //different variables to count cycles for different stages of pipeline
-        unsigned int cyc_in_fetch;
-        unsigned int cyc_in_decode;
-        unsigned int cyc_in_rename;
-        unsigned int cyc_in_register_read;
-        unsigned int cyc_in_dispatch;
-        unsigned int cyc_in_issue_queue;
-        unsigned int cyc_in_exec;
-        unsigned int cyc_in_writeback;
-        unsigned int cyc_in_retire;
-        //register tags
-        int src1;
-        int src2;
-        int dst;
-
-        unsigned int operation_type;
-        unsigned int execution_latency;
+        uint64_t sequence;
+        uint64_t instr_cycle_at_fetch;
+        //cycle (relative to the fetch cycle) in which every stage was left and
+        //the next one entered, indexed by stage - FETCH. for RETIRE it is the
+        //cycle after the retire
+        uint32_t stage_end[9];
         //rob related
-        int rob_index;
+        int16_t rob_index;
         //src tag in rob entries
-        int src1_rob;
-        int src2_rob;
-        //weether src is ready in rob
-        bool src1_rob_rdy; 
-        bool src2_rob_rdy;
+        int16_t src1_rob;
+        int16_t src2_rob;
+        //register tags
+        int8_t src1;
+        int8_t src2;
+        int8_t dst;
 
-        unsigned int super_scalar_slot;
-        unsigned int instr_cycle_at_fetch; 
+        uint8_t operation_type;
+        uint8_t execution_latency;
+        uint8_t current_stage : 4;
+        //weether src is ready in rob
+        uint8_t src1_rob_rdy : 1;
+        uint8_t src2_rob_rdy : 1;
 	
 	
 	public:
         //initialize the instruction when it is fetched
-        void instruction_initialize(unsigned long pc_val, unsigned int op_type, unsigned int dst_val, unsigned int src1_val, unsigned src2_val);
+        void instruction_initialize(unsigned int op_type, int dst_val, int src1_val, int src2_val);
 
         //setter getter methods
         //for rob src registers
@@ -82,15 +81,11 @@ class instruction
             return src2_rob_rdy;
         }
 
-        unsigned long get_pc(){
-            return pc;
-        }
-
         //sets the age for the instruction via the sequence number
-        void set_sequence(unsigned int seq){
+        void set_sequence(uint64_t seq){
             sequence = seq;
         }
-        unsigned int get_sequence(){
+        uint64_t get_sequence(){
             return sequence;
         }
 
@@ -100,18 +95,20 @@ class instruction
         unsigned int get_execution_latency(){
             return execution_latency;
         }
-        //set the current stage the instruction is in the pipeline
-        void set_current_stage(unsigned int stage){
+        //move the instruction to the next stage, which it enters in the given
+        //cycle (the cycle after the one in which the stage passes it on)
+        void enter_stage(unsigned int stage, uint64_t cycle){
+            stage_end[current_stage - FETCH] = cycle - instr_cycle_at_fetch;
             current_stage = stage;
         }
-
-        //set the cycles in the current stage of pipeline
-        void set_cycles_in_current_stage(unsigned int cycles);
-        //get the  cycles spent in the current stage
-        //useful for moving the instruction to the next state
-        unsigned int get_cycles_in_current_stage();
-        //increment the number of cycles in the current stage of the instruction
-        void incr_cycles_for_current_stage();
+        //the instruction retires in the given cycle
+        void set_retire_cycle(uint64_t cycle){
+            stage_end[RETIRE - FETCH] = cycle + 1 - instr_cycle_at_fetch;
+        }
+        //cycle in which the instruction entered its current stage
+        uint64_t get_current_stage_start(){
+            return current_stage == FETCH ? instr_cycle_at_fetch : instr_cycle_at_fetch + stage_end[current_stage - 1 - FETCH];
+        }
     
         //rob entry set in the rename stage
         void set_rob_entry(int robtag){
@@ -146,21 +143,25 @@ class instruction
             return dst;
         }
 
-        //function to set the superscalar slot for this instruction
-        void set_superscalar_slot(unsigned int super_slot)	{super_scalar_slot = super_slot;}
-
-        //get method for super scalar slot value
-        unsigned int get_super_slot()					{return super_scalar_slot;}
-        
         //this function is used when moving instructions from 1 stage to the next
         unsigned int get_current_stage()		{return current_stage;}
 
         
         //this function will be called by the fetch stage
-        void set_start_cycle(unsigned int cyc)	{instr_cycle_at_fetch = cyc;}
+        //the instruction is in FETCH from this cycle on
+        void set_start_cycle(uint64_t cyc){
+            instr_cycle_at_fetch = cyc;
+            current_stage = FETCH;
+        }
 
         //print the isntruction stats after the retire and commit to ARF
         void printstats();
+
+        //same line as printstats, formatted into the output sink instead
+        void write_stats(timing_writer *out);
+
+        //binary record of the same timing for the binary timing log
+        void write_record(timing_writer *out);
     
         //this function is only for debugging purposes
         //
@@ -171,35 +172,70 @@ class instruction
 
 void instruction::printstats()
 {
-    printf("%u ",sequence);
+    printf("%" PRIu64 " ",sequence);
     printf("fu{%u} ",operation_type);
     printf("src{%d,%d} ",src1,src2);
     printf("dst{%d} ",dst);
 
     //cycles in a given pipeline stage
-    unsigned int cycles;
-    cycles = instr_cycle_at_fetch;
-    printf("FE{%u,%u} ",cycles, cyc_in_fetch);
-    cycles = cycles + cyc_in_fetch;
-    printf("DE{%u,%u} ",cycles, cyc_in_decode);
-    cycles = cycles + cyc_in_decode;
-    printf("RN{%u,%u} ",cycles, cyc_in_rename);
-    cycles = cycles + cyc_in_rename;
-    printf("RR{%u,%u} ",cycles, cyc_in_register_read);
-    cycles = cycles + cyc_in_register_read;
-    printf("DI{%u,%u} ",cycles, cyc_in_dispatch);
-    cycles = cycles + cyc_in_dispatch;
-    printf("IS{%u,%u} ",cycles, cyc_in_issue_queue);
-    cycles = cycles + cyc_in_issue_queue;
-    printf("EX{%u,%u} ",cycles, cyc_in_exec);
-    cycles = cycles + cyc_in_exec;
-    printf("WB{%u,%u} ",cycles, cyc_in_writeback);
-    cycles = cycles + cyc_in_writeback;
-    printf("RT{%u,%u} ",cycles, cyc_in_retire);
+    static const char *stage_names[9] = {"FE", "DE", "RN", "RR", "DI", "IS", "EX", "WB", "RT"};
+    uint32_t start = 0;
+    for(int i = 0; i < 9; i++)
+    {
+        printf(i == 8 ? "%s{%" PRIu64 ",%u}" : "%s{%" PRIu64 ",%u} ", stage_names[i], instr_cycle_at_fetch + start, stage_end[i] - start);
+        start = stage_end[i];
+    }
 
     printf("\n");
 }
 
+void instruction::write_stats(timing_writer *out)
+{
+    out->begin_line();
+    out->put_uint(sequence);
+    out->put_str(" fu{");
+    out->put_uint(operation_type);
+    out->put_str("} src{");
+    out->put_int(src1);
+    out->put_char(',');
+    out->put_int(src2);
+    out->put_str("} dst{");
+    out->put_int(dst);
+    out->put_str("} ");
+
+    //cycles in a given pipeline stage
+    static const char *stage_names[9] = {"FE{", "DE{", "RN{", "RR{", "DI{", "IS{", "EX{", "WB{", "RT{"};
+    uint32_t start = 0;
+    for(int i = 0; i < 9; i++)
+    {
+        out->put_str(stage_names[i]);
+        out->put_uint(instr_cycle_at_fetch + start);
+        out->put_char(',');
+        out->put_uint(stage_end[i] - start);
+        out->put_str(i == 8 ? "}\n" : "} ");
+        start = stage_end[i];
+    }
+}
+
+void instruction::write_record(timing_writer *out)
+{
+    timing_log_record rec;
+    rec.sequence = sequence;
+    rec.fetch_cycle = instr_cycle_at_fetch;
+    uint32_t start = 0;
+    for(int i = 0; i < 9; i++)
+    {
+        rec.durations[i] = stage_end[i] - start;
+        start = stage_end[i];
+    }
+    rec.op_type = operation_type;
+    rec.src1 = src1;
+    rec.src2 = src2;
+    rec.dst = dst;
+    out->begin_line();
+    out->put_bytes(&rec, sizeof(rec));
+}
+
 void instruction::display_instruction()
 {
 	//information that is relevant at any clock cycle
@@ -210,93 +246,15 @@ void instruction::display_instruction()
 	//4. destination and source registers
 	//5. rob entry and renamed source registers
 	printf("\n\tCurrent Stage		:%u\n", current_stage);
-	printf("\tSequence num 		:%u\n", sequence);
+	printf("\tSequence num 		:%" PRIu64 "\n", sequence);
 	printf("\tExecution latency: %u, Operation type: %u\n", execution_latency, operation_type);
 	printf("\tDst: %d, Src1: %d, Src2: %d\n", dst, src1, src2);
 	printf("\tROB dst: %d, ROB src1: %d, ROB src2: %d\n", rob_index, src1_rob, src2_rob);
 }
 
-unsigned int instruction::get_cycles_in_current_stage()
-{
-	unsigned int cycles;
-	switch(current_stage)
-	{
-		case FETCH:
-			cycles = cyc_in_fetch;
-			break;
-		case DECODE:
-			cycles = cyc_in_decode;
-			break;
-		case DISPATCH:
-			cycles = cyc_in_dispatch;
-			break;
-		case RENAME:
-			cycles = cyc_in_rename;
-			break;
-		case REG_READ:
-			cycles = cyc_in_register_read;
-			break;
-		case ISSUE_QUEUE:
-			cycles = cyc_in_issue_queue;
-			break;
-		case EXECUTE:
-			cycles = cyc_in_exec;
-			break;
-		case WRITE_BACK:
-			cycles = cyc_in_writeback;
-			break;
-		case RETIRE:
-			cycles = cyc_in_retire;
-			break;
-		default:
-			cycles = 0;
-			cout << "incorrect current stage" << endl;
-			break;
-	}
-	
-	return cycles;
-}
-
-void instruction::set_cycles_in_current_stage(unsigned int cycles)
-{
-	switch(current_stage)
-	{
-		case FETCH:
-			cyc_in_fetch = cycles;
-			break;
-		case DECODE:
-			cyc_in_decode = cycles;
-			break;
-		case DISPATCH:
-			cyc_in_dispatch = cycles;
-			break;
-		case RENAME:
-			cyc_in_rename = cycles;
-			break;
-		case REG_READ:
-			cyc_in_register_read = cycles;
-			break;
-		case ISSUE_QUEUE:
-			cyc_in_issue_queue = cycles;
-			break;
-		case EXECUTE:
-			cyc_in_exec = cycles;
-			break;
-		case WRITE_BACK:
-			cyc_in_writeback = cycles;
-			break;
-		case RETIRE:
-			cyc_in_retire = cycles;
-			break;
-		default:
-			break;
-	}
-}
-
-void instruction::instruction_initialize(unsigned long pc_val, unsigned int op_type, unsigned int dst_val, unsigned int src1_val, unsigned src2_val)
+void instruction::instruction_initialize(unsigned int op_type, int dst_val, int src1_val, int src2_val)
 {
 	operation_type = op_type;
-	pc = pc_val;
 	dst = dst_val;
 	src1 = src1_val;
 	src2 = src2_val;
@@ -304,51 +262,8 @@ void instruction::instruction_initialize(unsigned long pc_val, unsigned int op_t
 	//-1 indicates that it doesn't need a rob index
 	src1_rob = -1;
 	src2_rob = -1;
-	cyc_in_fetch = 0;
-	cyc_in_decode = 0;
-	cyc_in_rename = 0;
-	cyc_in_register_read = 0;
-	cyc_in_dispatch = 0;
-	cyc_in_issue_queue = 0;
-	cyc_in_exec = 0;
-	cyc_in_writeback = 0;
-	cyc_in_retire = 0;
-}
-
-void instruction::incr_cycles_for_current_stage()
-{
-	switch(current_stage)
-	{
-		case FETCH:
-			cyc_in_fetch++;
-			break;
-		case DECODE:
-			cyc_in_decode++;
-			break;
-		case DISPATCH:
-			cyc_in_dispatch++;
-			break;
-		case RENAME:
-			cyc_in_rename++;
-			break;
-		case REG_READ:
-			cyc_in_register_read++;
-			break;
-		case ISSUE_QUEUE:
-			cyc_in_issue_queue++;
-			break;
-		case EXECUTE:
-			cyc_in_exec++;
-			break;
-		case WRITE_BACK:
-			cyc_in_writeback++;
-			break;
-		case RETIRE:
-			cyc_in_retire++;
-			break;
-		default:
-			cout << "incorrect current stage" << endl;
-	}
+	for(int i = 0; i < 9; i++)
+		stage_end[i] = 0;
 }
 
 void instruction::calculate_latency()
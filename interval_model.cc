@@ -0,0 +1,196 @@
+//analytical interval model (--model)
+//estimates the cycles of the detailed pipeline for a finite ROB, IQ and width
+//without simulating every stage every cycle. the trace is walked once and the
+//cycle in which every bundle leaves every stage is computed directly:
+//1. front end (FE, DE, RN, RR, DI): a bundle leaves a stage one cycle after it
+//   entered it, once the next stage has passed on the bundle before it (the
+//   latches hold one bundle). rename also waits for WIDTH free ROB entries
+//   (in order retire frees them) and dispatch for WIDTH free IQ entries
+//2. issue: an instruction issues once it is in the IQ and its producers have
+//   finished execute, at most WIDTH per cycle. slots are handed out in program
+//   order, which stands in for the oldest first select
+//3. retire: in order, at most WIDTH per cycle, after writeback
+//what it leaves out (select does not see the IQ, bundles do not split) makes
+//it an estimate. --model-check prints how far off it is for a configuration
+#include <stdio.h>
+#include <stdint.h>
+#include <inttypes.h>
+
+#include <vector>
+#include <queue>
+#include <functional>
+
+#include "sim_proc.h"
+
+typedef struct model_result{
+	uint64_t instructions;
+	uint64_t cycles;
+}model_result;
+
+//issue slots per cycle, kept for a window of cycles around the current one
+class issue_slot_window
+{
+	private:
+		std::vector<uint64_t> cycle_of;
+		std::vector<unsigned int> used;
+		uint64_t mask;
+		unsigned int width;
+
+	public:
+        //window must cover the furthest an issue can lie ahead of a dispatch
+		void slot_window_initialize(uint64_t window, unsigned int width){
+            uint64_t size = 1;
+            while(size < window)
+                size <<= 1;
+            cycle_of.assign(size, UINT64_MAX);
+            used.assign(size, 0);
+            mask = size - 1;
+            this->width = width;
+        }
+
+        //takes the first issue slot at or after cycle, returns its cycle
+		uint64_t take_slot(uint64_t cycle){
+            while(true)
+            {
+                uint64_t k = cycle & mask;
+                if(cycle_of[k] != cycle)
+                {
+                    cycle_of[k] = cycle;
+                    used[k] = 0;
+                }
+                if(used[k] < width)
+                {
+                    used[k]++;
+                    return cycle;
+                }
+                cycle++;
+            }
+        }
+};
+
+void run_interval_model(trace_reader *trace, proc_params *params, model_result *result)
+{
+	uint64_t width = params->width;
+	uint64_t rob_size = params->rob_size;
+	uint64_t iq_size = params->iq_size;
+
+	//latency of every op type, straight from the instruction model
+	uint64_t latency[3];
+	for(int op = 0; op < 3; op++)
+	{
+		instruction instr;
+		instr.instruction_initialize(op, -1, -1, -1);
+		instr.calculate_latency();
+		latency[op] = instr.get_execution_latency();
+	}
+
+	//cycle from which the dependents of every register's latest producer can
+	//issue (the producer wakes them up in its last execute cycle)
+	uint64_t reg_ready[128] = {0};
+
+	//retire cycles of the last instructions, for the ROB and retire width
+	uint64_t retire_size = 1;
+	while(retire_size < rob_size + width + 1)
+		retire_size <<= 1;
+	std::vector<uint64_t> retire_cycle(retire_size, 0);
+	uint64_t last_retire = 0;
+
+	//issue cycles of the instructions in the IQ (earliest first)
+	std::priority_queue<uint64_t, std::vector<uint64_t>, std::greater<uint64_t> > iq_leave;
+
+	issue_slot_window slots;
+	slots.slot_window_initialize(8 * (6 * rob_size + iq_size + 64), width);
+
+	//cycle in which the previous bundle left FE, DE, RN, RR and DI
+	uint64_t prev_fe = 0, prev_de = 0, prev_rn = 0, prev_rr = 0, prev_di = 0;
+	bool first_bundle = true;
+
+	result->instructions = 0;
+	result->cycles = 0;
+
+	std::vector<trace_record> bundle(width);
+	unsigned int n;
+	while((n = trace->read_instrs(&bundle[0], width)) != 0)
+	{
+		uint64_t first = result->instructions;
+
+		//front end. a stage passes a bundle on once the next stage passed on the
+		//bundle before it (the stages run from retire to fetch in a cycle)
+		uint64_t fe = first_bundle ? 0 : std::max(prev_fe + 1, prev_de);
+		uint64_t de = first_bundle ? fe + 1 : std::max(fe + 1, prev_rn);
+		uint64_t rn = first_bundle ? de + 1 : std::max(de + 1, prev_rr);
+		//rename needs WIDTH free ROB entries: the instruction ROB_SIZE entries
+		//before the last one of a full bundle has to be retired
+		if(first + width - 1 >= rob_size)
+		{
+			uint64_t oldest = first + width - 1 - rob_size;
+			if(oldest < first && retire_cycle[oldest & (retire_size - 1)] > rn)
+				rn = retire_cycle[oldest & (retire_size - 1)];
+		}
+		uint64_t rr = first_bundle ? rn + 1 : std::max(rn + 1, prev_di);
+		uint64_t di = rr + 1;
+		//dispatch needs WIDTH free IQ entries. entries issued in a cycle are free
+		//for dispatch in the same cycle
+		while(!iq_leave.empty() && iq_leave.top() <= di)
+			iq_leave.pop();
+		while(iq_leave.size() + width > iq_size && !iq_leave.empty())
+		{
+			di = std::max(di, iq_leave.top());
+			while(!iq_leave.empty() && iq_leave.top() <= di)
+				iq_leave.pop();
+		}
+
+		for(unsigned int k = 0; k < n; k++)
+		{
+			trace_record& rec = bundle[k];
+			uint64_t seq = result->instructions++;
+			uint64_t lat = latency[(rec.op_type >= 0 && rec.op_type < 3) ? rec.op_type : 0];
+
+			//in the IQ from the cycle after dispatch, issue once the sources are ready
+			uint64_t issue = di + 1;
+			if(rec.src1 >= 0 && reg_ready[rec.src1] > issue)
+				issue = reg_ready[rec.src1];
+			if(rec.src2 >= 0 && reg_ready[rec.src2] > issue)
+				issue = reg_ready[rec.src2];
+			issue = slots.take_slot(issue);
+			iq_leave.push(issue);
+
+			//EX from the next cycle for lat cycles, then WB and RT
+			uint64_t writeback = issue + 1 + lat;
+			if(rec.dst >= 0)
+				reg_ready[rec.dst] = writeback - 1;
+
+			//in order retire, at most WIDTH per cycle
+			uint64_t retire = writeback + 2;
+			if(last_retire > retire)
+				retire = last_retire;
+			if(seq >= width)
+			{
+				uint64_t width_back = retire_cycle[(seq - width) & (retire_size - 1)];
+				if(width_back + 1 > retire)
+					retire = width_back + 1;
+			}
+			retire_cycle[seq & (retire_size - 1)] = retire;
+			last_retire = retire;
+		}
+
+		prev_fe = fe;
+		prev_de = de;
+		prev_rn = rn;
+		prev_rr = rr;
+		prev_di = di;
+		first_bundle = false;
+	}
+	//the simulation ends in the cycle after the last retire
+	result->cycles = result->instructions ? last_retire + 1 : 0;
+}
+
+//prints how far the model is off from a detailed simulation of the same run
+void print_model_error(model_result *model, uint64_t detailed_cycles)
+{
+	double error = detailed_cycles ? 100.0 * ((double) model->cycles - (double) detailed_cycles) / detailed_cycles : 0.0;
+	printf("# === Interval Model ============\n");
+	printf("# Model Cycles                 = %" PRIu64 "\n", model->cycles);
+	printf("# Model IPC                    = %.2lf\n", model->cycles ? (double) model->instructions / model->cycles : 0.0);
+	printf("# Model Error (cycles)         = %+.2lf%%\n", error);
+}
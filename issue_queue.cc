@@ -1,6 +1,8 @@
 #include <vector>
 
 #include <stdio.h>
+#include <stdint.h>
+#include <inttypes.h>
 #include <iostream>
 using namespace std;
 
@@ -13,7 +15,7 @@ class issue_queue_entry
         //issue queue is open for a new entry, valid = false
 		bool valid;
         //age matrix for the isntruction entry
-        unsigned int seq;
+        uint64_t seq;
         //tags for source register
 		int src1;
 		int src2;
@@ -27,8 +29,6 @@ class issue_queue_entry
         //is the src ready (can be udpated from the wakeup from execute)
 		bool src2_rdy;
 		bool src1_rdy;
-        //count the number of cycles 
-		unsigned int cycles;
 };
 
 class issue_queue
@@ -40,15 +40,47 @@ class issue_queue
         unsigned int iq_size;
 		unsigned int iq_pipeline_width;
 
+        //packed state for the select logic (bit i belongs to entry i)
+        //number of 64 bit words needed for one mask
+		unsigned int iq_words;
+        //entry holds an instruction
+		vector<uint64_t> valid_mask;
+        //entry is valid and both of its sources are ready
+		vector<uint64_t> ready_mask;
+        //age matrix. row i has a bit set for every entry that is older than entry i
+        //row i is stored in words [i*iq_words, (i+1)*iq_words)
+		vector<uint64_t> age_matrix;
+		unsigned int num_valid_entries;
+
+        //wakeup lists. every rob entry keeps a linked list of the issue queue sources
+        //waiting on it, so a finishing instruction only touches its actual consumers
+        //a list node is one source of one entry: node 2*i is src1 of entry i, 2*i+1 is src2
+        //first node waiting on each rob tag, -1 if nobody is waiting
+		vector<int> wakeup_head;
+        //next node in the same list
+		vector<int> wakeup_next;
+
+        //recompute the ready bit of an entry after one of its sources woke up
+		void update_ready_bit(int index){
+            if(iq[index].valid && iq[index].src1_rdy && iq[index].src2_rdy)
+                ready_mask[index >> 6] |= (uint64_t) 1 << (index & 63);
+        }
+
 	public:
 		
 
         //initialize issue queue
-		void issue_queue_initialize(unsigned int iq_size, unsigned int width);
+        //rob size is needed to create one wakeup list per rob entry
+		void issue_queue_initialize(unsigned int iq_size, unsigned int width, unsigned int rob_size);
 
         //sets the age of the instruction in the pipeline
-        void set_sequence(unsigned int index, unsigned int sequence)	{iq[index].seq = sequence;}
-		unsigned int get_sequence(unsigned int idx)	{return iq[idx].seq;}
+        void set_sequence(unsigned int index, uint64_t sequence)	{iq[index].seq = sequence;}
+		uint64_t get_sequence(unsigned int idx)	{return iq[idx].seq;}
+
+        //rob tag of the instruction sitting in an entry
+        int get_dst_tag(int index){
+            return iq[index].dst_tag;
+        }
 
 
         int get_src1_rob(int index){
@@ -68,39 +100,33 @@ class issue_queue
 
         void make_src1_rdy(int index){
             iq[index].src1_rdy = true;
+            update_ready_bit(index);
         }
 		void make_src2_rdy(int index){
             iq[index].src2_rdy = true;
+            update_ready_bit(index);
         }
 
-        //cycle related methods
-        //get the cycle number for a givem index
-		unsigned int get_cyc(int index){
-            return iq[index].cycles;
-        }
-        //method to increment cycle
-		void incr_cyc(int index){
-            iq[index].cycles++;
-        }
-        //clear the cycles when sending to next stage
-		void clear_cyc(int index){
-            iq[index].cycles = 0;
-        }
-        //increment cycle for all the entries sitting in issue queue
-		void incr_cyc_for_all_valid_entries();
-		
 		//to check if there is a valid entry. Useful for issuing instruction to execute
 		bool has_valid_entries();
 
+		//the methods below are compiled for the issue queue size IQ_SIZE (and the
+		//width WIDTH) when the pipeline is compiled for a configuration, which
+		//fixes the number of mask words. 0 = the sizes given to issue_queue_initialize
+
 		//checks if issue queue has width amount of free entries
+		template<unsigned int WIDTH, unsigned int IQ_SIZE>
 		bool check_for_width_free_entries();
 		
+		template<unsigned int IQ_SIZE>
 		int find_oldest_ready_instr();
 		//finds the old instruction in the IQ and returns its index in the IQ
 
-		void set_iq_entry(int, int, int, unsigned int, int, bool, bool);
+		template<unsigned int IQ_SIZE>
+		void set_iq_entry(int, int, int, uint64_t, int, bool, bool);
 		//set values for a particular iq entry
 
+		template<unsigned int IQ_SIZE>
 		int get_free_entry();
 		//returns a free entry in the IQ
 		//
@@ -110,15 +136,27 @@ class issue_queue
 
 		void free_up_entry(int index){
             iq[index].valid = false;
+            valid_mask[index >> 6] &= ~((uint64_t) 1 << (index & 63));
+            ready_mask[index >> 6] &= ~((uint64_t) 1 << (index & 63));
+            num_valid_entries--;
+        }
+
+        //number of occupied entries
+		unsigned int get_num_valid_entries(){
+            return num_valid_entries;
         }
 
+		void register_for_wakeup(int index);
+		//adds the sources of an entry that are not ready yet to the wakeup list
+		//of the rob entry they wait on. called once the entry is dispatched
+
 		void make_entries_ready_with_src_as(int dst_in_rob);
-		//this function will look for valid entries 
-		//in the issue queue and make them ready
+		//this function will walk the wakeup list of the rob entry
+		//and make the waiting sources ready
 };
 
 
-void issue_queue::issue_queue_initialize(unsigned int iq_size, unsigned int width)
+void issue_queue::issue_queue_initialize(unsigned int iq_size, unsigned int width, unsigned int rob_size)
 {
 	this->iq_size = iq_size;
 	iq_pipeline_width = width;
@@ -126,53 +164,57 @@ void issue_queue::issue_queue_initialize(unsigned int iq_size, unsigned int widt
     //all the entries are free at the start
 	for(int i = 0; i < (int) iq_size; i++)
 		iq[i].valid = false;
+
+	//all the masks are allocated once here so select never touches the heap
+	iq_words = (iq_size + 63) / 64;
+	valid_mask.assign(iq_words, 0);
+	ready_mask.assign(iq_words, 0);
+	age_matrix.assign(iq_size * iq_words, 0);
+	num_valid_entries = 0;
+
+	//nobody is waiting on any rob entry at the start
+	wakeup_head.assign(rob_size, -1);
+	wakeup_next.assign(2 * iq_size, -1);
 }
 
-void issue_queue::incr_cyc_for_all_valid_entries()
+void issue_queue::register_for_wakeup(int index)
 {
-	for(int i = 0; i < (int) iq_size; i++)
+	//sources in the arf or already ready do not wait on anyone
+	if(iq[index].is_src1_in_arf == false && iq[index].src1_rdy == false)
+	{
+		wakeup_next[2 * index] = wakeup_head[iq[index].src1];
+		wakeup_head[iq[index].src1] = 2 * index;
+	}
+	if(iq[index].is_src2_in_arf == false && iq[index].src2_rdy == false)
 	{
-		if(iq[i].valid == true)
-			incr_cyc(i);
+		wakeup_next[2 * index + 1] = wakeup_head[iq[index].src2];
+		wakeup_head[iq[index].src2] = 2 * index + 1;
 	}
 }
 
 void issue_queue::make_entries_ready_with_src_as(int dst_in_rob)
 {
-	vector<int> valid_indices;	
-	//extract all the valid indices
-	for(int i = 0; i < (int) iq_size; i++)
-	{
-		if(iq[i].valid == true)
-			valid_indices.push_back(i);
-	}
-
-	if(valid_indices.size() != 0)
+	//a waiting source cannot issue before its producer finishes, so every node
+	//in the list still belongs to a valid entry
+	int node = wakeup_head[dst_in_rob];
+	while(node != -1)
 	{
-		for(int i = 0; i < (int) valid_indices.size(); i++)
-		{
-			if(iq[valid_indices[i]].src1 == dst_in_rob)
-				iq[valid_indices[i]].src1_rdy = true;
-
-			if(iq[valid_indices[i]].src2 == dst_in_rob)
-				iq[valid_indices[i]].src2_rdy = true;
-		}
+		int index = node >> 1;
+		if(node & 1)
+			iq[index].src2_rdy = true;
+		else
+			iq[index].src1_rdy = true;
+
+		update_ready_bit(index);
+		node = wakeup_next[node];
 	}
+	//everybody waiting on this rob entry is woken up
+	wakeup_head[dst_in_rob] = -1;
 }
 
 bool issue_queue::has_valid_entries()
 {
-	bool has_valid_entry = false;
-	for(int i = 0; i < (int) iq_size; i++)
-	{
-		if(iq[i].valid == true)
-		{
-			has_valid_entry = true;
-			break;
-		}
-	}
-	
-	return has_valid_entry;
+	return num_valid_entries != 0;
 }
 
 void issue_queue::display_contents()
@@ -181,26 +223,34 @@ void issue_queue::display_contents()
 	printf("\tSize: %u, SuperScalarWidth: %u\n", iq_size, iq_pipeline_width);
 	for(int i = 0; i < (int) iq_size; i++)
 	{
-		printf("valid: %u, dst: %d, src1: %d,%u, src2: %d,%u seq: %u\n", iq[i].valid, iq[i].dst_tag, iq[i].src1, iq[i].src1_rdy, iq[i].src2, iq[i].src2_rdy, iq[i].seq);
+		printf("valid: %u, dst: %d, src1: %d,%u, src2: %d,%u seq: %" PRIu64 "\n", iq[i].valid, iq[i].dst_tag, iq[i].src1, iq[i].src1_rdy, iq[i].src2, iq[i].src2_rdy, iq[i].seq);
 	}
 }
 
+template<unsigned int IQ_SIZE>
 int issue_queue::get_free_entry()
 {
+	const unsigned int words = IQ_SIZE ? (IQ_SIZE + 63) / 64 : iq_words;
 	int free_entry_index = -1;
-	for(int i = 0; i < (int) iq_size; i++)
+	for(int w = 0; w < (int) words; w++)
 	{
-		if(iq[i].valid == false)
+		uint64_t free_bits = ~valid_mask[w];
+		if(free_bits)
 		{
-			free_entry_index = i;
+			free_entry_index = w * 64 + __builtin_ctzll(free_bits);
 			break;
 		}
 	}
+	//the last word can have free bits past the end of the issue queue
+	if(free_entry_index >= (int) (IQ_SIZE ? IQ_SIZE : iq_size))
+		free_entry_index = -1;
 	return free_entry_index;
 }
 
-void issue_queue::set_iq_entry(int dst, int rs1, int rs2, unsigned int sequence, int index, bool src1_in_arf, bool src2_in_arf)
+template<unsigned int IQ_SIZE>
+void issue_queue::set_iq_entry(int dst, int rs1, int rs2, uint64_t sequence, int index, bool src1_in_arf, bool src2_in_arf)
 {
+	const unsigned int words = IQ_SIZE ? (IQ_SIZE + 63) / 64 : iq_words;
 	iq[index].dst_tag = dst;
 	iq[index].src1 = rs1;
 	iq[index].src2 = rs2;
@@ -209,7 +259,6 @@ void issue_queue::set_iq_entry(int dst, int rs1, int rs2, unsigned int sequence,
 	iq[index].is_src2_in_arf = src2_in_arf;
 	iq[index].src1_rdy = false;
 	iq[index].src2_rdy = false;
-	iq[index].cycles = 1;
 
 	//if source is in arf its always ready
 	if(src1_in_arf == true)
@@ -218,59 +267,64 @@ void issue_queue::set_iq_entry(int dst, int rs1, int rs2, unsigned int sequence,
 	if(src2_in_arf == true)
 		iq[index].src2_rdy = true;
 
+	//every entry already in the issue queue is older than the new one
+	uint64_t bit = (uint64_t) 1 << (index & 63);
+	for(int w = 0; w < (int) words; w++)
+	{
+		age_matrix[index * words + w] = valid_mask[w];
+		//and the new entry is younger than all of them
+		uint64_t bits = valid_mask[w];
+		while(bits)
+		{
+			int i = w * 64 + __builtin_ctzll(bits);
+			bits &= bits - 1;
+			age_matrix[i * words + (index >> 6)] &= ~bit;
+		}
+	}
+
 	iq[index].valid = true;
+	valid_mask[index >> 6] |= bit;
+	num_valid_entries++;
+	update_ready_bit(index);
 }
 
 
 
+template<unsigned int IQ_SIZE>
 int issue_queue::find_oldest_ready_instr()
 {
-	int oldest_instr_idx = 0;
-
-	vector<int> valid_indices;
-
-	//extract all the valid indices
-	for(int i = 0; i < (int) iq_size; i++)
-	{
-		if(iq[i].valid == true && iq[i].src1_rdy == true && iq[i].src2_rdy == true)
-			valid_indices.push_back(i);
-	}
-
-	if(valid_indices.size() != 0)
+	const unsigned int words = IQ_SIZE ? (IQ_SIZE + 63) / 64 : iq_words;
+	//the oldest ready entry is the one that has no ready entry older than itself
+	//i.e. its age matrix row does not overlap with the ready mask
+	for(int w = 0; w < (int) words; w++)
 	{
-		int valid_index = valid_indices[0];
-		for(int j = 0; j < (int) valid_indices.size(); j++)
+		uint64_t candidates = ready_mask[w];
+		while(candidates)
 		{
-			if(iq[valid_indices[j]].seq < iq[valid_index].seq)
-				valid_index = valid_indices[j];
+			int i = w * 64 + __builtin_ctzll(candidates);
+			candidates &= candidates - 1;
+
+			uint64_t *older = &age_matrix[i * words];
+			bool is_oldest = true;
+			for(int k = 0; k < (int) words; k++)
+			{
+				if(older[k] & ready_mask[k])
+				{
+					is_oldest = false;
+					break;
+				}
+			}
+			if(is_oldest)
+				return i;
 		}
-		oldest_instr_idx = valid_index;
-	}
-	else
-	{
-		//nothing is ready
-		oldest_instr_idx = -1;
 	}
 
-	return oldest_instr_idx;
+	//nothing is ready
+	return -1;
 }
 
+template<unsigned int WIDTH, unsigned int IQ_SIZE>
 bool issue_queue::check_for_width_free_entries()
 {
-	
-	int num_free_entries = 0;
-	bool dispatch = false;
-	for(int i = 0; i < (int) iq_size; i++)
-	{
-		if(iq[i].valid == false)
-			num_free_entries++;
-	}
-
-	//cout << "Debug from IQ class: number of free entries = " << num_free_entries << endl;
-
-	if(num_free_entries >= (int) iq_pipeline_width)
-		dispatch = true;
-	else
-		dispatch = false;
-	return dispatch;
+	return ((IQ_SIZE ? IQ_SIZE : iq_size) - num_valid_entries) >= (WIDTH ? WIDTH : iq_pipeline_width);
 }
@@ -0,0 +1,152 @@
+//C interface to the simulator, see libsim.h
+#include <stdio.h>
+#include <stdlib.h>
+#include "sim_proc.h"
+
+#include "simulator.cc"
+#include "libsim.h"
+
+struct sim_handle{
+	trace_reader trace;
+	simulator sim;
+};
+
+struct sim_trace{
+	trace_reader trace;
+	//records of a text trace, a binary trace stays mapped in trace
+	vector<trace_record> loaded;
+	const trace_record *recs;
+	uint64_t num_recs;
+};
+
+//opts has to be value initialized (sim_options opts = {}), only the settings
+//the C interface exposes are set here and every other one stays off
+static bool sim_config_to_params(const sim_config *cfg, proc_params *params, sim_options *opts)
+{
+	if(cfg->rob_size == 0 || cfg->rob_size > INSTR_MAX_ROB_SIZE || cfg->iq_size == 0 || cfg->width == 0 || cfg->interval_cycles == 0)
+		return false;
+	params->rob_size = cfg->rob_size;
+	params->iq_size = cfg->iq_size;
+	params->width = cfg->width;
+	if(!proc_params_valid(params))
+		return false;
+	opts->cycle_skip = cfg->cycle_skip != 0;
+	opts->specialize = cfg->specialize != 0;
+	opts->binary_sidecar = cfg->binary_sidecar != 0;
+	opts->prefetch_trace = cfg->prefetch_trace != 0;
+	opts->async_output = cfg->async_output != 0;
+	opts->quiet = cfg->print_instrs == 0;
+	opts->interval_log_file = cfg->interval_log;
+	opts->interval_cycles = cfg->interval_cycles;
+	opts->interval_instrs = cfg->interval_instrs;
+	opts->print_range_last = UINT64_MAX;
+	opts->timing_log_file = cfg->timing_log;
+	return true;
+}
+
+void sim_config_default(sim_config *cfg)
+{
+	cfg->rob_size = 256;
+	cfg->iq_size = 32;
+	cfg->width = 4;
+	cfg->cycle_skip = 1;
+	cfg->specialize = 1;
+	cfg->binary_sidecar = 1;
+	cfg->prefetch_trace = 0;
+	cfg->print_instrs = 0;
+	cfg->async_output = 0;
+	cfg->timing_log = NULL;
+	cfg->interval_log = NULL;
+	cfg->interval_cycles = 10000;
+	cfg->interval_instrs = 0;
+}
+
+sim_handle *sim_create(const sim_config *cfg, const char *trace_file)
+{
+	proc_params params;
+	sim_options opts = {};
+	if(!sim_config_to_params(cfg, &params, &opts))
+		return NULL;
+	sim_handle *h = new sim_handle;
+	if(!h->trace.trace_open(trace_file, opts.binary_sidecar, opts.prefetch_trace))
+	{
+		delete h;
+		return NULL;
+	}
+	if(!h->sim.simulator_initialize(&params, &opts, &h->trace, cfg->print_instrs != 0))
+	{
+		h->trace.trace_close();
+		delete h;
+		return NULL;
+	}
+	return h;
+}
+
+sim_trace *sim_trace_load(const char *trace_file)
+{
+	sim_trace *t = new sim_trace;
+	if(!t->trace.trace_open(trace_file, true, false))
+	{
+		delete t;
+		return NULL;
+	}
+	t->recs = t->trace.get_records(&t->num_recs);
+	if(t->recs == NULL)
+	{
+		t->num_recs = load_trace(&t->trace, t->loaded);
+		t->recs = t->loaded.empty() ? NULL : &t->loaded[0];
+	}
+	return t;
+}
+
+sim_handle *sim_create_shared(const sim_config *cfg, const sim_trace *trace)
+{
+	proc_params params;
+	sim_options opts = {};
+	if(!sim_config_to_params(cfg, &params, &opts))
+		return NULL;
+	sim_handle *h = new sim_handle;
+	h->trace.trace_open_records(trace->recs, trace->num_recs);
+	if(!h->sim.simulator_initialize(&params, &opts, &h->trace, cfg->print_instrs != 0))
+	{
+		delete h;
+		return NULL;
+	}
+	return h;
+}
+
+void sim_trace_free(sim_trace *trace)
+{
+	trace->trace.trace_close();
+	delete trace;
+}
+
+int sim_step(sim_handle *sim)
+{
+	return sim->sim.step() ? 1 : 0;
+}
+
+uint64_t sim_run_cycles(sim_handle *sim, uint64_t n)
+{
+	return sim->sim.run_n_cycles(n);
+}
+
+void sim_run_to_end(sim_handle *sim)
+{
+	sim->sim.run_to_end();
+}
+
+void sim_get_stats(sim_handle *sim, sim_stats *stats)
+{
+	stats->instructions = sim->sim.get_instruction_count();
+	stats->cycles = sim->sim.get_cycles();
+	stats->ipc = stats->cycles == 0 ? 0.0 : (double) stats->instructions / (double) stats->cycles;
+	stats->done = sim->sim.is_done() ? 1 : 0;
+}
+
+void sim_destroy(sim_handle *sim)
+{
+	sim->sim.simulator_close();
+	sim->trace.trace_close();
+	delete sim;
+}
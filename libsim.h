@@ -0,0 +1,85 @@
+/* C interface to the out of order pipeline simulator (libsim.a / libsim.so)
+
+   Every sim_handle is an independent simulation, so any number of them can
+   live in one process. A handle must only be used by one thread at a time,
+   different handles can be used from different threads.
+
+   Example:-
+   sim_config cfg;
+   sim_config_default(&cfg);
+   cfg.rob_size = 256; cfg.iq_size = 32; cfg.width = 4;
+   sim_handle *sim = sim_create(&cfg, "gcc_trace.txt");
+   sim_run_to_end(sim);
+   sim_stats stats;
+   sim_get_stats(sim, &stats);
+   sim_destroy(sim);
+*/
+#ifndef LIBSIM_H
+#define LIBSIM_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct sim_config{
+	unsigned long rob_size;	/* at most 32767 */
+	unsigned long iq_size;
+	unsigned long width;	/* at most rob_size and iq_size */
+	/* same meaning as the command line options of sim (1 = on) */
+	int cycle_skip;		/* on by default */
+	int specialize;		/* on by default */
+	int binary_sidecar;	/* on by default */
+	int prefetch_trace;	/* off by default */
+	/* print the timing of every instruction to stdout when it retires */
+	int print_instrs;	/* off by default */
+	/* write that log from a separate thread */
+	int async_output;	/* off by default */
+	/* binary timing log (timing_log.h) written to this file, NULL = none */
+	const char *timing_log;	/* NULL by default */
+	/* interval log (CSV) written to this file, NULL = none */
+	const char *interval_log;	/* NULL by default */
+	/* interval length in cycles, or in retired instructions when not 0 */
+	uint64_t interval_cycles;	/* 10000 by default */
+	uint64_t interval_instrs;	/* 0 by default */
+}sim_config;
+
+typedef struct sim_stats{
+	uint64_t instructions;	/* retired so far */
+	uint64_t cycles;
+	double ipc;
+	int done;
+}sim_stats;
+
+typedef struct sim_handle sim_handle;
+
+/* a trace loaded into memory once, to be shared by many simulations */
+typedef struct sim_trace sim_trace;
+
+void sim_config_default(sim_config *cfg);
+
+/* returns NULL if the configuration is invalid or the trace cannot be opened */
+sim_handle *sim_create(const sim_config *cfg, const char *trace_file);
+
+/* the trace must outlive every simulation created from it */
+sim_trace *sim_trace_load(const char *trace_file);
+sim_handle *sim_create_shared(const sim_config *cfg, const sim_trace *trace);
+void sim_trace_free(sim_trace *trace);
+
+/* simulates exactly one cycle (no cycle skipping), returns 1 once the
+   simulation is done */
+int sim_step(sim_handle *sim);
+/* simulates n more cycles (less if the trace ends), returns the cycles simulated */
+uint64_t sim_run_cycles(sim_handle *sim, uint64_t n);
+void sim_run_to_end(sim_handle *sim);
+
+void sim_get_stats(sim_handle *sim, sim_stats *stats);
+
+void sim_destroy(sim_handle *sim);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
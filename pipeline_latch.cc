@@ -0,0 +1,155 @@
+#include "sim_proc.h"
+#include <vector>
+
+#include <stdio.h>
+#include <assert.h>
+#include <iostream>
+using namespace std;
+
+//emulates a pipeline register (latch) between two stages
+//each latch only holds the instructions that are currently in its stage
+//so a stage never has to look at instructions sitting in other stages
+//instructions are kept in program order (oldest first)
+//the storage for a full bundle is allocated once, so moving instructions
+//through the latches never touches the heap
+class pipeline_latch
+{
+	private:
+        //slots for the instructions, the first size of them are in the latch
+		vector<instruction> bundle;
+		unsigned int size;
+        //maximum number of instructions the latch can hold (width)
+		unsigned int capacity;
+
+	public:
+        //allocate the storage for the latch once at the start of simulation
+		void latch_initialize(unsigned int capacity);
+
+        //number of instructions currently held in the latch
+		unsigned int get_size(){
+            return size;
+        }
+		bool is_empty(){
+            return size == 0;
+        }
+
+        //access the instruction at a given position (0 = oldest)
+		instruction& get_instr(unsigned int index){
+            return bundle[index];
+        }
+
+        //add an instruction to the latch. instructions are pushed in program order
+        //never more than capacity at a time
+		void push_instr(instruction& instr){
+            assert(size < capacity);
+            bundle[size++] = instr;
+        }
+
+        //empties the latch once the whole bundle has moved to the next stage
+		void clear(){
+            size = 0;
+        }
+};
+
+void pipeline_latch::latch_initialize(unsigned int capacity)
+{
+	this->capacity = capacity;
+	bundle.resize(capacity);
+	size = 0;
+}
+
+//list of rob tags for the back end stages (EX, WB, RT)
+//once dispatched, the instruction itself lives in the rob indexed by its tag
+//so the back end lists only need to track which tags are in which stage
+//push and remove are O(1): the position of every tag in the list is remembered
+//and the last tag is moved into the hole on removal (order is not preserved)
+//like the latches, the storage is allocated once for the largest list
+class rob_tag_list
+{
+	private:
+        //the first size slots hold the tags currently in the list
+		vector<int> tags;
+		unsigned int size;
+        //position of every rob tag inside tags, -1 if the tag is not in the list
+		vector<int> position;
+
+	public:
+        //the list can hold at most rob size tags
+		void tag_list_initialize(unsigned int rob_size);
+
+		unsigned int get_size(){
+            return size;
+        }
+		bool is_empty(){
+            return size == 0;
+        }
+
+        //tag at a given position of the list
+		int get_tag(unsigned int index){
+            return tags[index];
+        }
+
+		void push_tag(int rob_tag){
+            position[rob_tag] = size;
+            tags[size++] = rob_tag;
+        }
+
+        //removes a tag from anywhere in the list
+		void remove_tag(int rob_tag);
+
+		void clear();
+};
+
+void rob_tag_list::tag_list_initialize(unsigned int rob_size)
+{
+	tags.resize(rob_size);
+	size = 0;
+	position.assign(rob_size, -1);
+}
+
+void rob_tag_list::remove_tag(int rob_tag)
+{
+	int hole = position[rob_tag];
+	int last_tag = tags[size - 1];
+	//move the last tag into the hole left by the removed tag
+	tags[hole] = last_tag;
+	position[last_tag] = hole;
+	size--;
+	position[rob_tag] = -1;
+}
+
+void rob_tag_list::clear()
+{
+	for(int i = 0; i < (int) size; i++)
+		position[tags[i]] = -1;
+	size = 0;
+}
+
+//all the latches and per-stage lists of the pipeline
+//DE, RN, RR and DI hold at most one bundle (width instructions)
+//instructions in the issue queue are only tracked by the issue queue itself
+//EX, WB and RT hold the rob tags of the instructions in those stages
+typedef struct pipeline_latches{
+	//instructions read from the trace in one fetch (width records)
+	vector<trace_record> fetch_buffer;
+	pipeline_latch decode_latch;
+	pipeline_latch rename_latch;
+	pipeline_latch regread_latch;
+	pipeline_latch dispatch_latch;
+	rob_tag_list execute_list;
+	rob_tag_list writeback_list;
+	rob_tag_list retire_list;
+}pipeline_latches;
+
+//creates all the latches based on the processor configuration
+void pipeline_latches_initialize(pipeline_latches *latches, proc_params *param)
+{
+	latches->fetch_buffer.resize(param->width);
+	latches->decode_latch.latch_initialize(param->width);
+	latches->rename_latch.latch_initialize(param->width);
+	latches->regread_latch.latch_initialize(param->width);
+	latches->dispatch_latch.latch_initialize(param->width);
+	latches->execute_list.tag_list_initialize(param->rob_size);
+	latches->writeback_list.tag_list_initialize(param->rob_size);
+	latches->retire_list.tag_list_initialize(param->rob_size);
+}
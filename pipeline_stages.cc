@@ -5,32 +5,77 @@
 #include <inttypes.h>
 #include "sim_proc.h"
 
+#include "trace_reader.cc"
+#include "timing_writer.cc"
+#include "stage_profile.cc"
+#include "alloc_check.cc"
 #include "instruction.cc"
+#include "pipeline_latch.cc"
 #include "rmt.cc"
 #include "issue_queue.cc"
 #include "rob.cc"
+#include "pipeline_stats.cc"
 
+//the stages that depend on the configuration take WIDTH, ROB_SIZE and IQ_SIZE as
+//template arguments. the simulator compiles the pipeline once for the sizes in
+//proc_params (all 0, read at run time) and once for each of the common
+//configurations, where the sizes are constants (see simulator.cc)
 
-//increment the cycles in the current stage due to stall of the pipeline
-void incr_cycles_in_current_stage_due_to_stall(unsigned int stage, vector<instruction>& instructions_in_pipeline)
+
+//check whether a rob entry finished execution in this cycle
+//execute stage wakes up the dependent instructions in the same cycle (bypass)
+bool is_rob_tag_ready_this_cycle(pipeline_data *meta, int rob_tag)
 {
-	//loop through all the instructions in the pipeline and check against the stage which needs to be
-	//stalled
-	int no_of_instr_in_pipe = instructions_in_pipeline.size();
-	for(int i = 0; i < no_of_instr_in_pipe; i++)
+	return (meta->rob_tags_ready_this_cycle[rob_tag >> 6] >> (rob_tag & 63)) & 1;
+}
+
+//read the readiness of the src registers of an instruction from the rob
+//also catch the wakeups from the execute stage in the same cycle
+void read_src_readiness(pipeline_data *meta, instruction& instr, rob *rob)
+{
+	//get the src1 rob tag
+	//if it is not assigned any register tag or is available from ARF,
+	//it is assigned -1 (always ready)
+	int src1_rob = instr.get_src1_rob();
+	//check the rob entry to decide readiness
+	if(src1_rob != -1)
 	{
-		if(instructions_in_pipeline[i].get_current_stage() == stage)
-		{
-			//increment cycles_in_current_stage
-			instructions_in_pipeline[i].incr_cycles_for_current_stage();
-		}
+		//src1 is ready in rob
+		if(rob->is_rob_entry_ready(src1_rob) == true)
+			instr.set_src1_rob_rdy();
+		else
+			instr.clear_src1_rob_rdy();
+
+		//src1 is ready due to prewakeup from execution stage
+		if(is_rob_tag_ready_this_cycle(meta, src1_rob))
+			instr.set_src1_rob_rdy();
 	}
+	//do the same logic for src2
+	int src2_rob = instr.get_src2_rob();
+	if(src2_rob != -1)
+	{
+		if(rob->is_rob_entry_ready(src2_rob) == true)
+			instr.set_src2_rob_rdy();
+		else
+			instr.clear_src2_rob_rdy();
+
+		if(is_rob_tag_ready_this_cycle(meta, src2_rob))
+			instr.set_src2_rob_rdy();
+	}
+}
+
+//records that a stage held its instructions this cycle and why (--stats)
+void note_stall(pipeline_data *meta, int cause)
+{
+	meta->stats.stalls_this_cycle |= 1u << cause;
 }
 
 //fetch stage of the pipeline
-//read from the file width instructions at a time
-void fetch(pipeline_data *meta, proc_params *param, vector<instruction>& instructions_in_pipeline, FILE *FP)
+//read from the trace width instructions at a time
+template<unsigned int WIDTH>
+void fetch(pipeline_data *meta, proc_params *param, pipeline_latches *latches, trace_reader *trace)
 {
+	const unsigned int width = WIDTH ? WIDTH : param->width;
 	//1. Read width number of instructions in a single go
 	//2. assign meatadata to each instruction
 	//   -> seq number, pc, dst, src1, src2, op_type
@@ -38,69 +83,54 @@ void fetch(pipeline_data *meta, proc_params *param, vector<instruction>& instruc
 
 	//define a new instruction
 	instruction new_instruction;
-    unsigned int op_type;
-	unsigned int dst;
-	unsigned int src1; 
-	unsigned int src2;  // Variables are read from trace file
-	unsigned long pc;
 
 	//get new instructions only if decode stage is not busy (or has enough space available)
+	//if stalled, the fetched instructions are already sitting in the decode latch
+	//and wait there until decode passes them on
 	if(meta->decode_busy == false)
 	{
-		//fetch width number of instructions and store them onto a stack 
-		unsigned int super_slot = 0;
-		for(int i = 0; i < (int) param->width; i++) 
+		//fetch width number of instructions from the trace in one go
+		//fewer come back only when the trace is depleted
+		unsigned int num_fetched = trace->read_instrs(&latches->fetch_buffer[0], width);
+		if(num_fetched < width)
+			meta->trace_depleted_f = true;
+		for(int i = 0; i < (int) num_fetched; i++)
 		{
-			if(fscanf(FP, "%lx %d %d %d %d", &pc, &op_type, &dst, &src1, &src2) != EOF)
-			{
-				//increment the slot number
-				super_slot++;
-				
-				//create a new instruction with required meta data
-				new_instruction.instruction_initialize(pc, op_type, dst, src1, src2);
-
-				//store the instruction number for the instruction
-				new_instruction.set_sequence(meta->sequence);
-
-				//setting super scalar slot to keep track of where the instruction is in the slot
-				new_instruction.set_superscalar_slot(super_slot); 
-
-				//set current stage to FETCH
-				new_instruction.set_current_stage(FETCH);
-				//increment the cycle for fetch stage before passing onto the next state
-				new_instruction.incr_cycles_for_current_stage();
-				//send to DECODE stage next
-				new_instruction.set_current_stage(DECODE);
-				//set the starting cycle of the instruction as overall simulation cycle
-				new_instruction.set_start_cycle(meta->simulation_cycle);
-
-				//push the new instruction in the pipeline to keep track of all the instructions
-				//that enter the pipeline
-				//To not let the size of the vector to become big, I'll erase all the instructions
-				//in the retire stage. This way the size of the vector is dependent upon the width,
-				//rob size and issue queue rather than the number of instructions fed to the simulator
-				instructions_in_pipeline.push_back(new_instruction);
-				//increment the sequence for next instruction
-				//this is useful in rename, issue queue as well as during the retiring
-				//the oldest instruction is stored first, issued first if multiple instructions are ready
-				meta->sequence++; 
-				//indicate the fetch stage is no more busy and take a new instruction
-				//redudant tbh
-				meta->fetch_busy = false;
-			}
+			trace_record& rec = latches->fetch_buffer[i];
+
+			//create a new instruction with required meta data
+			new_instruction.instruction_initialize(rec.op_type, rec.dst, rec.src1, rec.src2);
+
+			//store the instruction number for the instruction
+			new_instruction.set_sequence(meta->sequence);
+
+			//set the starting cycle of the instruction as overall simulation cycle
+			//(this puts it in FETCH)
+			new_instruction.set_start_cycle(meta->simulation_cycle);
+			//fetch takes one cycle, DECODE starts in the next one
+			new_instruction.enter_stage(DECODE, meta->simulation_cycle + 1);
+
+			//push the new instruction in the decode latch
+			latches->decode_latch.push_instr(new_instruction);
+			meta->progress_this_cycle = true;
+			//keep track of all the instructions that enter the pipeline
+			//retire decrements this count
+			meta->num_instrs_in_pipeline++;
+			//increment the sequence for next instruction
+			//this is useful in rename, issue queue as well as during the retiring
+			//the oldest instruction is stored first, issued first if multiple instructions are ready
+			meta->sequence++;
+			//indicate the fetch stage is no more busy and take a new instruction
+			//redudant tbh
+			meta->fetch_busy = false;
 		}
 	}
-	//if stalled, incremenet the cycles in the current stage
-	//TODO: Current code does not handle counting of cycles in the fetch stage
-	//as the instruvtions that are fetched are basically moved to decode stage
-	else
-	{
-		incr_cycles_in_current_stage_due_to_stall(FETCH, instructions_in_pipeline);
-	}
+	else if(!meta->trace_depleted_f)
+		note_stall(meta, STALL_FETCH_DECODE_BUSY);
 }
 
 //decode stage
-void decode(pipeline_data *meta, proc_params *params, vector<instruction>& instructions_in_pipeline)
+void decode(pipeline_data *meta, proc_params *params, pipeline_latches *latches)
 {
 	//based on the operation type, calculate the execution cycles
 
@@ -108,51 +138,36 @@ void decode(pipeline_data *meta, proc_params *params, vector<instruction>& instr
 	//otherwise stall them
 	if(meta->rename_busy == false)
 	{
-		//loop through all the instructions in the pipeline and get only those 
-		//instructions that are in decode	
-		int no_of_instr_in_pipe = instructions_in_pipeline.size();
-		if(no_of_instr_in_pipe != 0)
+		//move the whole bundle sitting in the decode latch
+		pipeline_latch *de = &latches->decode_latch;
+		if(!de->is_empty())
+			meta->progress_this_cycle = true;
+		for(int i = 0; i < (int) de->get_size(); i++)
 		{
-			//loop through for width number of instructions
-			for(int j = 0; j < (int) params->width; j++) 
-			{
-				//get only those instructions that are in the decode stage
-				for(int i = 0; i < no_of_instr_in_pipe; i++)
-				{
-					if( instructions_in_pipeline[i].get_current_stage() == DECODE)
-					{
-						//calculate the execution cycles for the instruction
-						instructions_in_pipeline[i].calculate_latency();
-						//increment the cycles in the decode stage
-						instructions_in_pipeline[i].incr_cycles_for_current_stage();
-						//since rename stage is not busy, move the instructions to rename 
-						//stage
-						instructions_in_pipeline[i].set_current_stage(RENAME);
-						//break the loop for next instruction
-						break;
-					}
-				}
-			}
-			//once all the instructions have been moved, make the stage available
-			meta->decode_busy = false;
-		}
-		//if no instruction is in the pipeline then make the stage available
-		else
-		{
-			meta->decode_busy = false;
+			instruction& instr = de->get_instr(i);
+			//calculate the execution cycles for the instruction
+			instr.calculate_latency();
+			//since rename stage is not busy, move the instructions to rename
+			//stage. rename starts in the next cycle
+			instr.enter_stage(RENAME, meta->simulation_cycle + 1);
+			latches->rename_latch.push_instr(instr);
 		}
+		de->clear();
+		//once all the instructions have been moved, make the stage available
+		meta->decode_busy = false;
 	}
 	else
 	{
 		//since rename stage is busy/stalled, decode stage is also stalled
 		meta->decode_busy = true;
-		//increment number of cycles for each instruction in the decode stage when stalled
-		incr_cycles_in_current_stage_due_to_stall(DECODE, instructions_in_pipeline);
+		if(!latches->decode_latch.is_empty())
+			note_stall(meta, STALL_DECODE_RENAME_BUSY);
 	}
 }
 
 //rename stage
-void rename(pipeline_data *meta, proc_params* param, vector<instruction>& instructions_in_pipeline, rmt *rmt, rob *rob)
+template<unsigned int WIDTH, unsigned int ROB_SIZE>
+void rename(pipeline_data *meta, proc_params* param, pipeline_latches *latches, rmt *rmt, rob *rob)
 {
 	//rename stage functionality:
 	//1. read the source register tags
@@ -164,87 +179,80 @@ void rename(pipeline_data *meta, proc_params* param, vector<instruction>& instru
 	//  ii) dst registers:
 	//      -> store the tag into rob pointed by tail
 	//      -> make the rmt entry valid
-	if(instructions_in_pipeline.size() != 0)
+	if(meta->num_instrs_in_pipeline != 0)
 	{
+		pipeline_latch *rn = &latches->rename_latch;
 		if(meta->reg_read_busy == false)
 		{
 			//check if rob has free enteries
-			if(rob->check_width_amount_free_entries())
+			if(rob->check_width_amount_free_entries<WIDTH, ROB_SIZE>())
 			{
-				//loop through upto width number of enteries
-				for(int j = 0; j < (int) param->width; j++)
+				//rename the whole bundle sitting in the rename latch
+				if(!rn->is_empty())
+					meta->progress_this_cycle = true;
+				for(int i = 0; i < (int) rn->get_size(); i++)
 				{
-					//look for all the instructions that are in RENAME stage in the pipeline
-					for(int i = 0; i < (int) instructions_in_pipeline.size(); i++)
+					instruction& instr = rn->get_instr(i);
+					//metadata to be stored into rob
+					//assign the src and dst registers
+					int dst = instr.get_dst();
+					int src1 = instr.get_src1();
+					int src2 = instr.get_src2();
+
+					//check only if src have registers associated otherwise store them as
+					//"-1" in the rob as well
+					if(src1 != -1)
+					{
+						//if the src index has a valid rmt entry then only set the
+						//src rob (rename the src register with rob entry)
+						if(rmt->get_valid_bit(src1))
+						{
+							//get the src1 rob entry
+							int src1_rob = rmt->get_rob_tag(src1);
+							//store the metadata to be used later
+							instr.set_src1_rob(src1_rob);
+						}
+					}
+					else
+					{
+						//store "-1"  when source register is not used
+						instr.set_src1_rob(-1);
+					}
+					//do similar stuff for src2
+					if(src2 != -1)
 					{
-						if(instructions_in_pipeline[i].get_current_stage() == RENAME)
+						if(rmt->get_valid_bit(src2))
 						{
-							//increment the cycles for rename stage
-							instructions_in_pipeline[i].incr_cycles_for_current_stage();
-							//metadata to be stored into rob
-							//assign the src and dst registers
-							int dst = instructions_in_pipeline[i].get_dst();
-							int src1 = instructions_in_pipeline[i].get_src1();
-							int src2 = instructions_in_pipeline[i].get_src2();
-							//get the pc 
-							unsigned long pc = instructions_in_pipeline[i].get_pc();
-							unsigned int sequence = instructions_in_pipeline[i].get_sequence();
-							
-							//check only if src have registers associated otherwise store them as
-							//"-1" in the rob as well
-							if(src1 != -1)
-							{
-								//if the src index has a valid rmt entry then only set the
-								//src rob (rename the src register with rob entry)
-								if(rmt->get_valid_bit(src1))
-								{
-									//get the src1 rob entry
-									int src1_rob = rmt->get_rob_tag(src1);
-									//store the metadata to be used later
-									instructions_in_pipeline[i].set_src1_rob(src1_rob);
-								}
-							}
-							else
-							{
-								//store "-1"  when source register is not used
-								instructions_in_pipeline[i].set_src1_rob(-1);
-							}
-							//do similar stuff for src2
-							if(src2 != -1)
-							{
-								if(rmt->get_valid_bit(src2))
-								{
-									int src2_rob = rmt->get_rob_tag(src2);
-									instructions_in_pipeline[i].set_src2_rob(src2_rob);
-								}
-							}
-							else
-							{
-								instructions_in_pipeline[i].set_src2_rob(-1);
-							}
-							//allocate the rob entry with the necessary metadata
-							//get the rob tag for this entry
-							//this also updates dst with -1 (when no dst is specified)
-							unsigned int rob_tag = rob->allocate_rob_entry(pc, dst, sequence);
-							//store the rob tag associated with this instruction
-							//useful for subsequent stages
-							instructions_in_pipeline[i].set_rob_entry(rob_tag);
-							//store the rob entry in the rmt only  if dst register is available
-							//if not available, then the rmt does not contain that rob entry
-							if(dst != -1)
-							{
-								//store the rob entry in rmt indexed via dst reg 
-								//also set the valid bit to indicate it is stored in rob
-								rmt->set_rob_tag(dst, rob_tag);
-								rmt->set_valid_bit(dst);
-							}
-							
-							//set stage for the registers to REG_READ for register reads							
-							instructions_in_pipeline[i].set_current_stage(REG_READ);
-							break;
+							int src2_rob = rmt->get_rob_tag(src2);
+							instr.set_src2_rob(src2_rob);
 						}
 					}
+					else
+					{
+						instr.set_src2_rob(-1);
+					}
+					//allocate the rob entry with the necessary metadata
+					//get the rob tag for this entry
+					//this also updates dst with -1 (when no dst is specified)
+					unsigned int rob_tag = rob->allocate_rob_entry<ROB_SIZE>(dst);
+					//store the rob tag associated with this instruction
+					//useful for subsequent stages
+					instr.set_rob_entry(rob_tag);
+					//store the rob entry in the rmt only  if dst register is available
+					//if not available, then the rmt does not contain that rob entry
+					if(dst != -1)
+					{
+						//store the rob entry in rmt indexed via dst reg
+						//also set the valid bit to indicate it is stored in rob
+						rmt->set_rob_tag(dst, rob_tag);
+						rmt->set_valid_bit(dst);
+					}
+
+					//set stage for the registers to REG_READ for register reads
+					instr.enter_stage(REG_READ, meta->simulation_cycle + 1);
+					latches->regread_latch.push_instr(instr);
 				}
+				rn->clear();
 				//rename stage sent its instructions to register read
 				//and hence has space available
 				meta->rename_busy = false;
@@ -254,14 +262,16 @@ void rename(pipeline_data *meta, proc_params* param, vector<instruction>& instru
 			{
 				//stall the cycles till then
 				meta->rename_busy = true;
-				incr_cycles_in_current_stage_due_to_stall(RENAME, instructions_in_pipeline);
+				if(!rn->is_empty())
+					note_stall(meta, STALL_RENAME_ROB_FULL);
 			}
 		}
 		else
 		{
 			//if reg_read is stalled
-			incr_cycles_in_current_stage_due_to_stall(RENAME, instructions_in_pipeline);
 			meta->rename_busy = true;
+			if(!rn->is_empty())
+				note_stall(meta, STALL_RENAME_REGREAD_BUSY);
 		}
 	}
 	else
@@ -272,145 +282,46 @@ void rename(pipeline_data *meta, proc_params* param, vector<instruction>& instru
 }
 
 //register read stage
-void regread(pipeline_data *meta, proc_params *param, vector<instruction>& instructions_in_pipeline, rob *rob)
+void regread(pipeline_data *meta, proc_params *param, pipeline_latches *latches, rob *rob)
 {
 	//no modelling of the values
 	//hence can jsut read the readiness and that is enough for dispatch and issue queue
-	if(instructions_in_pipeline.size() !=0)
+	if(meta->num_instrs_in_pipeline != 0)
 	{
+		pipeline_latch *rr = &latches->regread_latch;
 		//dispatch state is not busy
 		if(meta->dispatch_busy == false)
 		{
-			//go thriugh all the n width number of instructions
-			for(int j = 0; j < (int) param->width; j++)
+			//go through the whole bundle sitting in the reg_read latch
+			if(!rr->is_empty())
+				meta->progress_this_cycle = true;
+			for(int i = 0; i < (int) rr->get_size(); i++)
 			{
-				//loop through all the instructions in pipeline and work with only those instructions
-				//that are in the reg_read stage
-				for(int i = 0; i < (int) instructions_in_pipeline.size(); i++)
-				{
-					if(instructions_in_pipeline[i].get_current_stage() == REG_READ)
-					{
-						//get the src1 rob tag
-						//if it is not assigned any register tag or is available from ARF,
-						//it is assigned -1 (always ready)
-						int src1_rob = instructions_in_pipeline[i].get_src1_rob();
-						//check the rob entry to decide readiness
-						if(src1_rob != -1) 
-						{	
-							//src1 is ready in rob
-							if(rob->is_rob_entry_ready(src1_rob) == true) {
-								instructions_in_pipeline[i].set_src1_rob_rdy();
-							}
-							else{
-								instructions_in_pipeline[i].clear_src1_rob_rdy(); 
-							}
-
-							//look for all the rob entries getting ready in this stage due to pre-wakeup
-							//from execution stage
-							for(int k = 0; k < (int) meta->rob_destinations_ready_this_cycle.size(); k++)
-							{
-								//get the src1 rob entry
-								if(src1_rob == meta->rob_destinations_ready_this_cycle[k])
-								{
-									//src1 is ready due to prewakeup
-									instructions_in_pipeline[i].set_src1_rob_rdy();
-								}
-							}
-						}
-						//do the same logic for src2
-						int src2_rob = instructions_in_pipeline[i].get_src2_rob();
-						if(src2_rob != -1) 
-						{
-							if(rob->is_rob_entry_ready(src2_rob) == true)
-							{
-								instructions_in_pipeline[i].set_src2_rob_rdy();
-							}
-							else
-								instructions_in_pipeline[i].clear_src2_rob_rdy();
-
-							for(int k = 0; k < (int) meta->rob_destinations_ready_this_cycle.size(); k++)
-							{
-								if(src2_rob == meta->rob_destinations_ready_this_cycle[k])
-								{
-									//cout << "(RR) wakeup from ex for rs2" << endl;
-									instructions_in_pipeline[i].set_src2_rob_rdy();
-								}
-							}
-						}
-						//increment number of cuycles in this reg_read stage
-						instructions_in_pipeline[i].incr_cycles_for_current_stage();
-						//send the instruction to DISPATCH stage
-						instructions_in_pipeline[i].set_current_stage(DISPATCH);
-						break;
-					}
-				}
+				instruction& instr = rr->get_instr(i);
+				//read the readiness of src registers from rob and bypass
+				read_src_readiness(meta, instr, rob);
+				//send the instruction to DISPATCH stage
+				instr.enter_stage(DISPATCH, meta->simulation_cycle + 1);
+				latches->dispatch_latch.push_instr(instr);
 			}
+			rr->clear();
 			meta->reg_read_busy = false;
 		}
 		//if dispatch stage is busy
 		else
 		{
 			//stall in reg_read stage
-			incr_cycles_in_current_stage_due_to_stall(REG_READ, instructions_in_pipeline);
 			//even during stall, ensure the src registers are getting ready due to bypass
-			//if the bundle exists in the reg_read stage then stall the upper stages
-			bool bundle_exists = false;
-			for(int j = 0; j < (int) param->width; j++)
-			{
-				for(int i = 0; i < (int) instructions_in_pipeline.size(); i++)
-				{
-					if(instructions_in_pipeline[i].get_current_stage() == REG_READ && (int) instructions_in_pipeline[i].get_super_slot() == j+1)
-					{
-						bundle_exists = true;
-						
-						//check the readiness just the way I did above
-						int src1_rob = instructions_in_pipeline[i].get_src1_rob();
-						if(src1_rob != -1) 
-						{
-							if(rob->is_rob_entry_ready(src1_rob) == true) 
-							{
-								instructions_in_pipeline[i].set_src1_rob_rdy();
-							}
-							else
-								instructions_in_pipeline[i].clear_src1_rob_rdy();
-							for(int k = 0; k < (int) meta->rob_destinations_ready_this_cycle.size(); k++)
-							{
-								if(src1_rob == meta->rob_destinations_ready_this_cycle[k])
-								{
-									instructions_in_pipeline[i].set_src1_rob_rdy();
-								}
-							}
-						}
-
-						int src2_rob = instructions_in_pipeline[i].get_src2_rob();
-						if(src2_rob != -1) 
-						{
-							if(rob->is_rob_entry_ready(src2_rob) == true)
-							{
-								instructions_in_pipeline[i].set_src2_rob_rdy();
-							}
-							else
-								instructions_in_pipeline[i].clear_src2_rob_rdy();
-							for(int k = 0; k < (int) meta->rob_destinations_ready_this_cycle.size(); k++)
-							{
-								if(src2_rob == meta->rob_destinations_ready_this_cycle[k])
-								{
-									instructions_in_pipeline[i].set_src2_rob_rdy();
-								}
-							}
-						}
-					}
-				}
-			}
+			for(int i = 0; i < (int) rr->get_size(); i++)
+				read_src_readiness(meta, rr->get_instr(i), rob);
 
 			//if dispatch is busy but reg_read is free. In that case, rename should sent
-			//instructions to reg_read		
+			//instructions to reg_read
 			//reg read is busy if the bundle is still in reg_read
-			if(bundle_exists == true)
-				meta->reg_read_busy = true;
 			//reg read is free if the bundle has moved forward
-			else if(bundle_exists == false)
-				meta->reg_read_busy = false;
+			meta->reg_read_busy = !rr->is_empty();
+			if(!rr->is_empty())
+				note_stall(meta, STALL_REGREAD_DISPATCH_BUSY);
 		}
 	}
 	else
@@ -421,169 +332,106 @@ void regread(pipeline_data *meta, proc_params *param, vector<instruction>& instr
 }
 
 //dispatch stage
-void dispatch(pipeline_data *meta, proc_params *param, vector<instruction>& instructions_in_pipeline, issue_queue *iq)
+template<unsigned int WIDTH, unsigned int IQ_SIZE>
+void dispatch(pipeline_data *meta, proc_params *param, pipeline_latches *latches, issue_queue *iq, rob *rob)
 {
 	//check for free entries in issue queue
 	//1.if width number of entries are available, dispatch them to issue queue
 	//2. stall if the entries are unavailable
-	//also ensure the ready is caught from bypass 
-	if(instructions_in_pipeline.size() != 0)
+	//also ensure the ready is caught from bypass
+	if(meta->num_instrs_in_pipeline != 0)
 	{
+		pipeline_latch *di = &latches->dispatch_latch;
 		//issue queue has width number of instructions
-		if(iq->check_for_width_free_entries() == true) 
+		if(iq->check_for_width_free_entries<WIDTH, IQ_SIZE>() == true)
 		{
 			meta->dispatch_busy = false;
-			for(int j = 0; j < (int) param->width; j++)
+			if(!di->is_empty())
+				meta->progress_this_cycle = true;
+			for(int i = 0; i < (int) di->get_size(); i++)
 			{
-				for(int i = 0; i < (int) instructions_in_pipeline.size(); i++)
+				instruction& instr = di->get_instr(i);
+				//get the index of the free entry
+				int free_index = iq->get_free_entry<IQ_SIZE>();
+				//get the rob entry index
+				int dst = instr.get_rob_entry();
+				//get the sequence
+				uint64_t sequence = instr.get_sequence();
+				int rs1;
+				bool rs1_is_in_arf = true;
+				if(instr.get_src1_rob() != -1)
 				{
-					//look for all those instructions that are currently in dispatch state
-					if(instructions_in_pipeline[i].get_current_stage() == DISPATCH)
-					{
-						//increment the number of cycles in dispatch state						
-						instructions_in_pipeline[i].incr_cycles_for_current_stage();
-						//get the index of the free entry
-						int free_index = iq->get_free_entry(); 
-						//get the rob entry index
-						int dst = instructions_in_pipeline[i].get_rob_entry();
-						//get the sequence
-						unsigned int sequence = instructions_in_pipeline[i].get_sequence();
-						int rs1;
-						bool rs1_is_in_arf = true;
-						if(instructions_in_pipeline[i].get_src1_rob() != -1)
-						{
-							rs1 = instructions_in_pipeline[i].get_src1_rob();
-							rs1_is_in_arf = false;
-						}
-						else
-							rs1 = instructions_in_pipeline[i].get_src1();
+					rs1 = instr.get_src1_rob();
+					rs1_is_in_arf = false;
+				}
+				else
+					rs1 = instr.get_src1();
 
-						int rs2;
-						bool rs2_is_in_arf = true;
-						if(instructions_in_pipeline[i].get_src2_rob() != -1)
-						{
-							rs2 = instructions_in_pipeline[i].get_src2_rob();
-							rs2_is_in_arf = false;
-						}
-						else
-							rs2 = instructions_in_pipeline[i].get_src2();
+				int rs2;
+				bool rs2_is_in_arf = true;
+				if(instr.get_src2_rob() != -1)
+				{
+					rs2 = instr.get_src2_rob();
+					rs2_is_in_arf = false;
+				}
+				else
+					rs2 = instr.get_src2();
 
-						//push the entry onto the issue queue
-						iq->set_iq_entry(dst, rs1, rs2, sequence, free_index, rs1_is_in_arf, rs2_is_in_arf);
+				//push the entry onto the issue queue
+				iq->set_iq_entry<IQ_SIZE>(dst, rs1, rs2, sequence, free_index, rs1_is_in_arf, rs2_is_in_arf);
 
-						//looking at global wakeups and making instruction ready if it matches
-						if(instructions_in_pipeline[i].get_src1_rob() != -1)
-						{
-							rs1 = instructions_in_pipeline[i].get_src1_rob();
-							
-							for(int k = 0; k < (int) meta->rob_destinations_ready_this_cycle.size(); k++)
-							{
-								if(rs1 == meta->rob_destinations_ready_this_cycle[k])
-								{
-									instructions_in_pipeline[i].set_src1_rob_rdy();
-									iq->make_src1_rdy(free_index);
-								}
-							}
-						}
-						if(instructions_in_pipeline[i].get_src2_rob() != -1)
-						{
-							rs2 = instructions_in_pipeline[i].get_src2_rob();
-							for(int k = 0; k < (int) meta->rob_destinations_ready_this_cycle.size(); k++)
-							{
-								if(rs2 == meta->rob_destinations_ready_this_cycle[k])
-								{
-									instructions_in_pipeline[i].set_src2_rob_rdy();
-									iq->make_src2_rdy(free_index);
-								}
-							}
-						}
-						//if ROB has the ready value, make sure to make it
-						//ready in the instruction queue
-						if(instructions_in_pipeline[i].get_src1_rob_rdy() == true)
-						{
-							iq->make_src1_rdy(free_index);
-						}
+				//looking at global wakeups and making instruction ready if it matches
+				if(instr.get_src1_rob() != -1 && is_rob_tag_ready_this_cycle(meta, instr.get_src1_rob()))
+				{
+					instr.set_src1_rob_rdy();
+					iq->make_src1_rdy(free_index);
+				}
+				if(instr.get_src2_rob() != -1 && is_rob_tag_ready_this_cycle(meta, instr.get_src2_rob()))
+				{
+					instr.set_src2_rob_rdy();
+					iq->make_src2_rdy(free_index);
+				}
+				//if ROB has the ready value, make sure to make it
+				//ready in the instruction queue
+				if(instr.get_src1_rob_rdy() == true)
+				{
+					iq->make_src1_rdy(free_index);
+				}
 
-						if(instructions_in_pipeline[i].get_src2_rob_rdy() == true)
-						{
-							//cout << "rs2: " << rs1 << " is ready" << endl;
-							iq->make_src2_rdy(free_index);
-						}
+				if(instr.get_src2_rob_rdy() == true)
+				{
+					iq->make_src2_rdy(free_index);
+				}
+				//sources that are still not ready wait on their producer's wakeup list
+				iq->register_for_wakeup(free_index);
 
-						
-						meta->issue_queue_empty = false;
+				meta->issue_queue_empty = false;
 
-						instructions_in_pipeline[i].set_current_stage(ISSUE_QUEUE);
-						break;
-					}
-				}
+				//the instruction waits in the issue queue from the next cycle
+				instr.enter_stage(ISSUE_QUEUE, meta->simulation_cycle + 1);
+				//from now on the instruction is reached through its rob tag
+				rob->set_instr(dst, instr);
 			}
+			di->clear();
 		}
 		else
 		{
-			bool bundle_exists = false;
-			for(int j = 0; j < (int) param->width; j++)
+			//the bundle waits in dispatch but still catches the wakeups
+			for(int i = 0; i < (int) di->get_size(); i++)
 			{
-				for(int i = 0; i < (int) instructions_in_pipeline.size(); i++)
-				{
-					if(instructions_in_pipeline[i].get_current_stage() == DISPATCH && (int) instructions_in_pipeline[i].get_super_slot() == j+1)
-					{
-						bundle_exists = true;
-						instructions_in_pipeline[i].set_current_stage(DISPATCH);
-						
-						int rs1;
-						if(instructions_in_pipeline[i].get_src1_rob() != -1)
-						{
-							rs1 = instructions_in_pipeline[i].get_src1_rob();
-						}
-						else
-							rs1 = instructions_in_pipeline[i].get_src1();
+				instruction& instr = di->get_instr(i);
+				if(instr.get_src1_rob() != -1 && is_rob_tag_ready_this_cycle(meta, instr.get_src1_rob()))
+					instr.set_src1_rob_rdy();
+				if(instr.get_src2_rob() != -1 && is_rob_tag_ready_this_cycle(meta, instr.get_src2_rob()))
+					instr.set_src2_rob_rdy();
 
-						int rs2;
-						if(instructions_in_pipeline[i].get_src2_rob() != -1)
-						{
-							rs2 = instructions_in_pipeline[i].get_src2_rob();
-						}
-						else
-							rs2 = instructions_in_pipeline[i].get_src2();
-
-						
-						if(instructions_in_pipeline[i].get_src1_rob() != -1)
-						{
-							rs1 = instructions_in_pipeline[i].get_src1_rob();
-							for(int k = 0; k < (int) meta->rob_destinations_ready_this_cycle.size(); k++)
-							{
-								if(rs1 == meta->rob_destinations_ready_this_cycle[k])
-								{
-									instructions_in_pipeline[i].set_src1_rob_rdy();
-								}
-							}
-						}
-						if(instructions_in_pipeline[i].get_src2_rob() != -1)
-						{
-							rs2 = instructions_in_pipeline[i].get_src2_rob();
-							for(int k = 0; k < (int) meta->rob_destinations_ready_this_cycle.size(); k++)
-							{
-								if(rs2 == meta->rob_destinations_ready_this_cycle[k])
-								{
-									instructions_in_pipeline[i].set_src2_rob_rdy();
-								}
-							}
-						}
-
-						
-						meta->issue_queue_empty = false;
-					}
-				}
+				meta->issue_queue_empty = false;
 			}
-			//if there are not enough entries
-			//increment cycles for instructions in dispatch
-			incr_cycles_in_current_stage_due_to_stall(DISPATCH, instructions_in_pipeline);
-
-			if(bundle_exists == true)
-				meta->dispatch_busy = true;
-			else if(bundle_exists == false)
-				meta->dispatch_busy = false;
+			//if there are not enough entries the bundle stays in dispatch
+
+			meta->dispatch_busy = !di->is_empty();
+			if(!di->is_empty())
+				note_stall(meta, STALL_DISPATCH_IQ_FULL);
 		}
 	}
 	else
@@ -593,38 +441,35 @@ void dispatch(pipeline_data *meta, proc_params *param, vector<instruction>& inst
 }
 
 //issue stage
-void issue(pipeline_data *meta, proc_params *param, vector<instruction>& instructions_in_pipeline, issue_queue *iq, rob *rob)
+template<unsigned int WIDTH, unsigned int IQ_SIZE>
+void issue(pipeline_data *meta, proc_params *param, pipeline_latches *latches, issue_queue *iq, rob *rob)
 {
+	const unsigned int width = WIDTH ? WIDTH : param->width;
 	//issue the ready instructions to execute stage
-	if(instructions_in_pipeline.size() != 0)
+	if(meta->num_instrs_in_pipeline != 0)
 	{
 		//check if issue queue has any valid entry
 		if(iq->has_valid_entries() == true)
 		{
 			//run through width number of instructions
-			for(int i = 0; i < (int) param->width; i++)
+			for(int i = 0; i < (int) width; i++)
 			{
 				//get the oldest instruction for issue to execute stage
-				int oldest_instr_idx = iq->find_oldest_ready_instr();
+				int oldest_instr_idx = iq->find_oldest_ready_instr<IQ_SIZE>();
+				if(i == 0 && oldest_instr_idx == -1)
+					note_stall(meta, STALL_ISSUE_NONE_READY);
 				if(oldest_instr_idx != -1)
 				{
-					unsigned int sequence = iq->get_sequence(oldest_instr_idx);
-					unsigned int cyc_of_instr_being_issued = iq->get_cyc(oldest_instr_idx);
-					for(int j = 0; j < (int) instructions_in_pipeline.size(); j++)
-					{
-						if(instructions_in_pipeline[j].get_sequence() == sequence)
-						{
-							instructions_in_pipeline[j].set_cycles_in_current_stage(cyc_of_instr_being_issued);
-							instructions_in_pipeline[j].set_current_stage(EXECUTE);
-							//increment cycles for execute
-							instructions_in_pipeline[j].incr_cycles_for_current_stage();
-						}
-					}
-					iq->clear_cyc(oldest_instr_idx);
+					//the issue queue entry carries the rob tag of the instruction
+					int rob_tag = iq->get_dst_tag(oldest_instr_idx);
+					instruction& instr = rob->get_instr(rob_tag);
+					//execute starts in the next cycle
+					instr.enter_stage(EXECUTE, meta->simulation_cycle + 1);
+					latches->execute_list.push_tag(rob_tag);
+					meta->progress_this_cycle = true;
 					iq->free_up_entry(oldest_instr_idx);
 				}
 			}
-			iq->incr_cyc_for_all_valid_entries();
 		}
 		else
 		{
@@ -638,29 +483,31 @@ void issue(pipeline_data *meta, proc_params *param, vector<instruction>& instruc
 	}
 }
 
-void execute(pipeline_data *meta, proc_params *param, vector<instruction>& instructions_in_pipeline, rob *rob, issue_queue *iq)
+void execute(pipeline_data *meta, proc_params *param, pipeline_latches *latches, rob *rob, issue_queue *iq)
 {
-	if(instructions_in_pipeline.size() != 0)
+	if(meta->num_instrs_in_pipeline != 0)
 	{
-		for(int j = 0; j < (int) instructions_in_pipeline.size(); j++)
+		rob_tag_list *ex = &latches->execute_list;
+		int j = 0;
+		while(j < (int) ex->get_size())
 		{
-			if(instructions_in_pipeline[j].get_current_stage() == EXECUTE)
+			int dst_in_rob = ex->get_tag(j);
+			instruction& instr = rob->get_instr(dst_in_rob);
+			//done in the last of its latency cycles in execute
+			if(meta->simulation_cycle == instr.get_current_stage_start() + instr.get_execution_latency() - 1)
 			{
+				instr.enter_stage(WRITE_BACK, meta->simulation_cycle + 1);
 
-				if(instructions_in_pipeline[j].get_cycles_in_current_stage() == instructions_in_pipeline[j].get_execution_latency())
-				{
-					
-					instructions_in_pipeline[j].set_current_stage(WRITE_BACK);
-					
-					int dst_in_rob = instructions_in_pipeline[j].get_rob_entry();
-					meta->rob_destinations_ready_this_cycle.push_back(dst_in_rob);			
-					iq->make_entries_ready_with_src_as(dst_in_rob);
-				}
-				else
-				{
-					instructions_in_pipeline[j].incr_cycles_for_current_stage();
-				}
+				meta->rob_tags_ready_this_cycle[dst_in_rob >> 6] |= (uint64_t) 1 << (dst_in_rob & 63);
+				iq->make_entries_ready_with_src_as(dst_in_rob);
+
+				latches->writeback_list.push_tag(dst_in_rob);
+				meta->progress_this_cycle = true;
+				//the last tag of the list moves into position j
+				ex->remove_tag(dst_in_rob);
 			}
+			else
+				j++;
 		}
 	}
 	else
@@ -670,75 +517,60 @@ void execute(pipeline_data *meta, proc_params *param, vector<instruction>& instr
 }
 
 //writeback stage is used to send bypass values to IQ and also update the ready bit in the rob
-void writeback(pipeline_data *meta, vector<instruction>& instructions_in_pipeline, rob *rob)
+void writeback(pipeline_data *meta, pipeline_latches *latches, rob *rob)
 {
 	//For theinstructions in WB stage
-	//1. Increment number of cycles in the stage
+	//1. They spend exactly one cycle in the stage
 	//  -> instructions are never stalled in the wb stage
 	//2. Get the rob entry for the instruction
-	//  -> used to make that rob entry index ready 
+	//  -> used to make that rob entry index ready
 	//3. Set the current stage of all the instructions in WB as RETIRE
-	//when there are instrutions in the pipeline 
-	if(instructions_in_pipeline.size() != 0)
+	rob_tag_list *wb = &latches->writeback_list;
+	if(!wb->is_empty())
+		meta->progress_this_cycle = true;
+	for(int j = 0; j < (int) wb->get_size(); j++)
 	{
-			//get only those instructions that are in writeback stage
-		for(int j = 0; j < (int) instructions_in_pipeline.size(); j++)
-		{
-			if(instructions_in_pipeline[j].get_current_stage() == WRITE_BACK)
-			{
-				//increment the cycles for in pipeline for the WB stage
-				instructions_in_pipeline[j].incr_cycles_for_current_stage();
-				//get the rob index of all the instructions that are done with
-				//execution and are in WB
-				int rob_index = instructions_in_pipeline[j].get_rob_entry();
-				//set that particular rob entry ready for retirement
-				rob->set_rob_entry_ready(rob_index);
-
-				//look for all the instructions that are ready after the execution
-				//and free up their memory
-				for(int k = 0; k < (int) meta->rob_destinations_ready_this_cycle.size(); k++)
-				{
-					if(meta->rob_destinations_ready_this_cycle[k] == rob_index)
-					{
-						//remove all the rob indexes for which the execution is done
-						meta->rob_destinations_ready_this_cycle.erase(meta->rob_destinations_ready_this_cycle.begin() + k);
-					}
-				}
-				//set the stage for these instructions to retire
-				instructions_in_pipeline[j].set_current_stage(RETIRE);
-			}
-		}
+		//get the rob index of all the instructions that are done with
+		//execution and are in WB
+		int rob_index = wb->get_tag(j);
+		instruction& instr = rob->get_instr(rob_index);
+		//set that particular rob entry ready for retirement
+		rob->set_rob_entry_ready(rob_index);
+
+		//the rob entry holds the result from now on, so the bypass of the
+		//previous cycle is over
+		meta->rob_tags_ready_this_cycle[rob_index >> 6] &= ~((uint64_t) 1 << (rob_index & 63));
+		//set the stage for these instructions to retire
+		instr.enter_stage(RETIRE, meta->simulation_cycle + 1);
+		latches->retire_list.push_tag(rob_index);
 	}
+	wb->clear();
 }
 
 
 //retire stage for the pipeline
 //retire width number of instructions from rob into ARF
-void retire(pipeline_data *meta, proc_params *param, rob *rob, vector<instruction>& instructions_in_pipeline, rmt *rmt)
+template<unsigned int WIDTH, unsigned int ROB_SIZE>
+void retire(pipeline_data *meta, proc_params *param, rob *rob, pipeline_latches *latches, rmt *rmt)
 {
+	const unsigned int width = WIDTH ? WIDTH : param->width;
 	//steps in retire stage
 	//1. get all the instructions in the retire stage
-	//2. increment the cycle number for the instructions that are yet to be retired (head has not reached them yet)
-	//3. retire upto width number of instructions if they are ready (and head has reached there)
-	//4. free up all the rob indexes from which instructions have retired
-	//5. no need to reset rmt entry if the destintation was -1
+	//2. retire upto width number of instructions if they are ready (and head has reached there)
+	//3. free up all the rob indexes from which instructions have retired
+	//4. no need to reset rmt entry if the destintation was -1
 	//   -> reset the rmt entries if rob index matches the rmt entry
 	//get head and tail
 	unsigned int head = rob->get_head();
 	//when there are instructions in the pipeline
-	if(instructions_in_pipeline.size() != 0)
+	if(meta->num_instrs_in_pipeline != 0)
 	{
-		//check the stage in which all the instructions are available
-		for(int i = 0; i < (int) instructions_in_pipeline.size(); i++)
-		{
-			if(instructions_in_pipeline[i].get_current_stage() == RETIRE)
-			{
-				//increment the cycle number for all the instructions in this stage
-				instructions_in_pipeline[i].incr_cycles_for_current_stage();
-			}
-		}
+		rob_tag_list *rt = &latches->retire_list;
+		//nothing to retire while the ROB holds instructions
+		if(!rob->is_ready_to_retire(head) && rob->get_num_valid_entries() != 0)
+			note_stall(meta, STALL_RETIRE_HEAD_NOT_READY);
 		//check upto width number for instructions for retiring
-		for(int i = 0; i < (int) param->width; i++)
+		for(int i = 0; i < (int) width; i++)
 		{
 			//if the instruction at head is ready to retire
 			//this condition inherently takes care of the rob being empty
@@ -746,10 +578,9 @@ void retire(pipeline_data *meta, proc_params *param, rob *rob, vector<instructio
 			//increment the head
 			if(rob->is_ready_to_retire(head))
 			{
-				//get the age/sequence of the instruction that will be retired
-				//useful for printing at  the end when instruction is retired
-				unsigned int sequence = rob->get_sequence_for_entry(head);
 				//retire the instruction pointed by head
+				unsigned int retired_tag = head;
+				meta->progress_this_cycle = true;
 				rob->retire_entry(head);
 
 				//get the rmt table index to remove it from rmt
@@ -765,34 +596,79 @@ void retire(pipeline_data *meta, proc_params *param, rob *rob, vector<instructio
 				}
 
 				//emulate the cyclic buffer when incrementing head
-				if(head == (param->rob_size) - 1)
-					rob->set_head(0);
-				else
-					rob->set_head(head++);
-
-				for(int i = 0; i < (int) instructions_in_pipeline.size(); i++)
+				head = rob->next_tag<ROB_SIZE>(head);
+				rob->set_head(head);
+
+				//the instruction at head is reached directly through its rob tag
+				rob->get_instr(retired_tag).set_retire_cycle(meta->simulation_cycle);
+				//before commiting instruction in ARF, print the contents of the instruction
+				//(only the instructions in the print range)
+				if(meta->instr_log != NULL || meta->instr_bin_log != NULL)
 				{
-					if(instructions_in_pipeline[i].get_sequence() == sequence)
+					instruction& retired = rob->get_instr(retired_tag);
+					if(retired.get_sequence() >= meta->log_first && retired.get_sequence() <= meta->log_last)
 					{
-						//before commiting instruction in ARF, print the contents of the instruction	
-						instructions_in_pipeline[i].printstats();
-						//remove the vector from memory
-						instructions_in_pipeline.erase(instructions_in_pipeline.begin() + i);
-						//if all instructions are removed, the simulation is done
-						if(instructions_in_pipeline.size() == 0)
-						{
-							//all instructions in pipeline are committed
-							//simulation is done
-							meta->is_simulation_done = true;
-						}
+						if(meta->instr_log != NULL)
+							PROFILE_STAGE(meta, PROF_OUTPUT, retired.write_stats(meta->instr_log));
+						if(meta->instr_bin_log != NULL)
+							PROFILE_STAGE(meta, PROF_OUTPUT, retired.write_record(meta->instr_bin_log));
 					}
 				}
+				//remove the instruction from the retire list
+				rt->remove_tag(retired_tag);
+				meta->num_instrs_in_pipeline--;
+				meta->num_retired++;
+				//if all instructions are removed, the simulation is done
+				if(meta->num_instrs_in_pipeline == 0)
+				{
+					//all instructions in pipeline are committed
+					//simulation is done
+					meta->is_simulation_done = true;
+				}
 			}
 		}
 	}
 	else
 	{
-		//instructions are yet to be sent to peipeline
-		meta->is_simulation_done = false;
+		//an empty pipeline is only done once fetch found the trace depleted
+		//(an empty trace never puts an instruction in the pipeline)
+		meta->is_simulation_done = meta->trace_depleted_f;
+	}
+}
+
+//skip the cycles in which nothing can move in the pipeline
+//called at the end of a cycle. if no stage moved an instruction in this cycle,
+//the next cycles behave exactly the same (every stage stays stalled) until the
+//first instruction in execute finishes. the stages only record the cycle in
+//which an instruction moves on, so skipping those cycles is just moving the
+//cycle count forward
+//returns the number of cycles skipped, never more than max_skip
+uint64_t skip_quiescent_cycles(pipeline_data *meta, pipeline_latches *latches, rob *rob, uint64_t max_skip)
+{
+	if(meta->progress_this_cycle == true || meta->is_simulation_done == true)
+		return 0;
+
+	//the next event is the earliest execute completion
+	//an instruction finishing in cycle d leaves the cycles between this one and
+	//d as pure stall cycles
+	rob_tag_list *ex = &latches->execute_list;
+	if(ex->is_empty())
+		return 0;
+	uint64_t skip = UINT64_MAX;
+	for(int j = 0; j < (int) ex->get_size(); j++)
+	{
+		instruction& instr = rob->get_instr(ex->get_tag(j));
+		uint64_t done_cycle = instr.get_current_stage_start() + instr.get_execution_latency() - 1;
+		uint64_t cycles_left = done_cycle - meta->simulation_cycle - 1;
+		if(cycles_left < skip)
+			skip = cycles_left;
 	}
+	//never jump past the cycle a caller asked to stop at
+	if(skip > max_skip)
+		skip = max_skip;
+	if(skip == 0)
+		return 0;
+
+	meta->simulation_cycle += skip;
+	return skip;
 }
@@ -0,0 +1,113 @@
+//stall causes and ROB/IQ occupancy of a run (--stats)
+//the stages mark why they held their instructions in pipeline_data.stats;
+//at the end of every cycle the marks and the occupancies are counted
+#include <stdio.h>
+#include <stdint.h>
+#include <inttypes.h>
+
+#include "sim_proc.h"
+
+void pipeline_stats_initialize(pipeline_stats *stats, proc_params *params)
+{
+	stats->stalls_this_cycle = 0;
+	for(int i = 0; i < NUM_STALL_CAUSES; i++)
+		stats->stall_cycles[i] = 0;
+	stats->rob_occupancy.assign(params->rob_size + 1, 0);
+	stats->iq_occupancy.assign(params->iq_size + 1, 0);
+	stats->rob_occupancy_sum = 0;
+	stats->iq_occupancy_sum = 0;
+}
+
+//counts the stalls and occupancies of the cycle that just ended
+//a skipped quiescent cycle looks exactly like the cycle before it, so the
+//cycle and all the cycles skipped after it are counted at once
+void record_cycle_stats(pipeline_stats *stats, rob *rob, issue_queue *iq, uint64_t cycles)
+{
+	uint32_t stalls = stats->stalls_this_cycle;
+	while(stalls)
+	{
+		stats->stall_cycles[__builtin_ctz(stalls)] += cycles;
+		stalls &= stalls - 1;
+	}
+	stats->stalls_this_cycle = 0;
+	stats->rob_occupancy[rob->get_num_valid_entries()] += cycles;
+	stats->iq_occupancy[iq->get_num_valid_entries()] += cycles;
+	stats->rob_occupancy_sum += (uint64_t) rob->get_num_valid_entries() * cycles;
+	stats->iq_occupancy_sum += (uint64_t) iq->get_num_valid_entries() * cycles;
+}
+
+//interval log (--interval-log)
+//one CSV row per interval, only built from counters that are kept anyway,
+//so the log costs a handful of subtractions per interval
+void take_interval_snapshot(interval_snapshot *snap, pipeline_data *meta)
+{
+	snap->cycle = meta->simulation_cycle;
+	snap->retired = meta->num_retired;
+	snap->rob_occupancy_sum = meta->stats.rob_occupancy_sum;
+	snap->iq_occupancy_sum = meta->stats.iq_occupancy_sum;
+	for(int i = 0; i < NUM_STALL_CAUSES; i++)
+		snap->stall_cycles[i] = meta->stats.stall_cycles[i];
+}
+
+void write_interval_header(FILE *out)
+{
+	fprintf(out, "end_cycle,retired,cycles,instructions,ipc,rob_occupancy,iq_occupancy,"
+		"stall_fetch_decode_busy,stall_decode_rename_busy,stall_rename_rob_full,stall_rename_regread_busy,"
+		"stall_regread_dispatch_busy,stall_dispatch_iq_full,stall_issue_none_ready,stall_retire_head_not_ready\n");
+}
+
+//writes the row of the interval that started at last and ends now
+//and starts the next interval
+void write_interval_row(FILE *out, interval_snapshot *last, pipeline_data *meta)
+{
+	interval_snapshot now;
+	take_interval_snapshot(&now, meta);
+	uint64_t cycles = now.cycle - last->cycle;
+	if(cycles == 0)
+		return;
+	uint64_t instrs = now.retired - last->retired;
+	fprintf(out, "%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%.4f,%.2f,%.2f",
+		now.cycle, now.retired, cycles, instrs, (double) instrs / cycles,
+		(double) (now.rob_occupancy_sum - last->rob_occupancy_sum) / cycles,
+		(double) (now.iq_occupancy_sum - last->iq_occupancy_sum) / cycles);
+	for(int i = 0; i < NUM_STALL_CAUSES; i++)
+		fprintf(out, ",%" PRIu64, now.stall_cycles[i] - last->stall_cycles[i]);
+	fprintf(out, "\n");
+	*last = now;
+}
+
+//prints one occupancy histogram, only the occupancies that were seen
+void print_occupancy(FILE *out, const char *name, std::vector<uint64_t>& histogram, uint64_t total_cycles)
+{
+	double sum = 0;
+	for(int n = 0; n < (int) histogram.size(); n++)
+		sum += (double) n * histogram[n];
+	fprintf(out, "# === %s Occupancy (mean %.2f) ===\n", name, total_cycles ? sum / total_cycles : 0.0);
+	fprintf(out, "# %8s %12s %7s\n", "entries", "cycles", "share");
+	for(int n = 0; n < (int) histogram.size(); n++)
+	{
+		if(histogram[n] == 0)
+			continue;
+		fprintf(out, "# %8d %12" PRIu64 " %6.2f%%\n", n, histogram[n], total_cycles ? 100.0 * histogram[n] / total_cycles : 0.0);
+	}
+}
+
+void print_pipeline_stats(FILE *out, pipeline_stats *stats, uint64_t total_cycles)
+{
+	static const char *cause_names[NUM_STALL_CAUSES] = {
+		"fetch: decode busy",
+		"decode: rename busy",
+		"rename: ROB full",
+		"rename: regread busy",
+		"regread: dispatch busy",
+		"dispatch: IQ full",
+		"issue: none ready",
+		"retire: head not done",
+	};
+	fprintf(out, "# === Stall Cycles ==============\n");
+	for(int i = 0; i < NUM_STALL_CAUSES; i++)
+		fprintf(out, "# %-24s %12" PRIu64 " %6.2f%%\n", cause_names[i], stats->stall_cycles[i],
+			total_cycles ? 100.0 * stats->stall_cycles[i] / total_cycles : 0.0);
+	print_occupancy(out, "ROB", stats->rob_occupancy, total_cycles);
+	print_occupancy(out, "IQ", stats->iq_occupancy, total_cycles);
+}
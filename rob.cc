@@ -1,96 +1,36 @@
 #include <vector>
 
 #include <stdio.h>
+#include <stdint.h>
+#include <inttypes.h>
 #include <iostream>
 using namespace std;
 
-//contains all the values associated with a single
-//rob entry
-class rob_entry
-{
-	private:
-        //rob index. used for rename and retire stage
-		unsigned int rob_index; 
-        //whether the entry is contains an active instrcution
-        //in pipeline
-        //valid = true --> contained in the pipeline
-        //valid = false --> is available to store a new instrcution 
-		bool valid; 
-        //arf destination tag
-		int arf_dst;
-        //ready bit indicating the instruction is ready to be retired 
-        //ready = true --> ready to retire to ARF
-        //ready = false --> instrcution still in pipeline
-		bool ready; 
-        //age of the instruction
-		unsigned int seq;
-		unsigned long pc; 
-
-    public:
-        //setter getter methods for all the class variables
-        //sets the rob index when a rob entry is given in rename stage
-        void set_rob_index(unsigned int rob_entry_index){
-            rob_index = rob_entry_index;
-        }
-        
-        //valid bit
-		void set_valid_bit(){
-            valid = true;
-        }
-		bool get_valid_bit(){
-            return valid;
-        }		
-		void clear_valid_bit(){
-            valid = false;
-        }
-
-        //ready bits
-		void set_ready_bit(){
-            ready = true;
-        }
-        bool get_ready_bit(){
-            return ready;
-        }
-        void clear_ready_bit(){
-            ready = false;
-        }
-
-        //arf destination tag
-		void set_arf_dst(unsigned int dst_tag){
-            arf_dst = dst_tag;
-        }
-		int get_arf_dst(){
-            return arf_dst;
-        }
-
-        //age matrix for instructions
-        //sets the age matrix for an instruction
-		void set_sequence(unsigned int sequence){
-            seq = sequence;
-        }
-		unsigned int get_sequence(){
-            return seq;
-        }
-		
-        //set the pc for the entry
-		void set_pc(unsigned long pc){
-            pc = pc;
-        }
-
-		//display function for debugging purposes
-		void display_line();
-};
-
-void rob_entry::display_line()
-{
-	printf("\n\tindex: %u\tdst: %d\trdy: %u\tv: %u\tpc: %lu\tseq: %u", rob_index, arf_dst, ready, valid, pc, seq);
-}
-
 class rob
 {
 	private:
-        //create vector for all the rob entries
-		vector<rob_entry> rob;
+        //state of every rob entry, one column per field instead of one struct per entry
+        //valid: the entry holds an instruction that is still in the pipeline
+        //ready: the instruction is ready to be retired to the ARF
+        //both are bit packed (bit i belongs to entry i), the rest of an entry
+        //only matters while it is valid
+		vector<uint64_t> valid_bits;
+		vector<uint64_t> ready_bits;
+        //arf destination tag of every entry (-1 if none)
+		vector<int16_t> arf_dst;
+
+		bool test_bit(vector<uint64_t>& bits, unsigned int rob_tag){
+            return (bits[rob_tag >> 6] >> (rob_tag & 63)) & 1;
+        }
+		void set_bit(vector<uint64_t>& bits, unsigned int rob_tag){
+            bits[rob_tag >> 6] |= (uint64_t) 1 << (rob_tag & 63);
+        }
+		void clear_bit(vector<uint64_t>& bits, unsigned int rob_tag){
+            bits[rob_tag >> 6] &= ~((uint64_t) 1 << (rob_tag & 63));
+        }
+        //in-flight instruction records indexed by rob tag
+        //an instruction is stored here when it is dispatched and stays till it retires
+		vector<instruction> rob_instrs;
         //based on rob size will create the depth of the cyclic buffer
 		unsigned int rob_size;
         //head and tail for popping and pushing the instructions in the buffer
@@ -98,6 +38,8 @@ class rob
 		unsigned int rob_tail;
         //determines the number of instructions that need to be retired together
 		unsigned int pipeline_width_for_rob_retire;
+        //number of valid entries (instructions between rename and retire)
+		unsigned int num_valid_entries;
 	
 	public:
         //initalize rob class variables 
@@ -107,13 +49,13 @@ class rob
 
         //make the rob entry ready. used by WB stage
         void set_rob_entry_ready(int rob_tag){
-            rob[rob_tag].set_ready_bit();
+            set_bit(ready_bits, rob_tag);
         }
 
         //check if rob entry is ready. used by register read and issue queue stage
         //to send the instruction to execution
 		bool is_rob_entry_ready(unsigned int rob_tag){
-            return rob[rob_tag].get_ready_bit();
+            return test_bit(ready_bits, rob_tag);
         }
 
 		//sets the rob head for instruction retire to arf
@@ -134,41 +76,71 @@ class rob
             return rob_tail;
         }
 
+        //next rob tag after a given one in the cyclic buffer
+        //ROB_SIZE is the rob size when the pipeline is compiled for it (0 = the
+        //size given to rob_initialize). a power of two wraps with a mask
+        template<unsigned int ROB_SIZE>
+        unsigned int next_tag(unsigned int rob_tag){
+            if(ROB_SIZE != 0 && (ROB_SIZE & (ROB_SIZE - 1)) == 0)
+                return (rob_tag + 1) & (ROB_SIZE - 1);
+            return (rob_tag == (ROB_SIZE ? ROB_SIZE : rob_size) - 1) ? 0 : rob_tag + 1;
+        }
+
         //allocates a rob entry ni the rename stage. This function also increments
         //the tail after allocation
         //Also, return the rob index where the entry was stored
         //useful for storing index in rename table
-		unsigned int allocate_rob_entry(unsigned long pc_val, int dst_val, unsigned int seq);
+        template<unsigned int ROB_SIZE>
+		unsigned int allocate_rob_entry(int dst_val);
 
         
         //check if the width number of spaces are available in rob. this is to ensure 
         //instructions dont move from rename to register read till all the width number
         //of instructions are stored in rob
+        //WIDTH is the width when the pipeline is compiled for it, 0 otherwise
         //TODO: Think and understand 
+        template<unsigned int WIDTH, unsigned int ROB_SIZE>
 		bool check_width_amount_free_entries();
         
+        //check if a rob entry holds an instruction that is still in the pipeline
+        bool is_rob_entry_valid(unsigned int rob_tag){
+            return test_bit(valid_bits, rob_tag);
+        }
+
         //check if the instruction with a given rob tag is ready to retire
         //retire onlyw when this returns true
+        //a freed entry keeps its ready bit (its value is in the ARF for the
+        //instructions renamed to it), so the valid bit has to be checked too
 		bool is_ready_to_retire(unsigned int rob_tag){
-            return rob[rob_tag].get_ready_bit();
+            return test_bit(valid_bits, rob_tag) && test_bit(ready_bits, rob_tag);
         }
 		
         //retires the rob entry
         //head is incremented in the main retire pipeline to ensure the width number of instructions
         //can be retired together
 		void retire_entry(unsigned int rob_tag){
-            rob[rob_tag].clear_valid_bit();
-        }
-		
-        //get the age of the rob entry 
-        //useful for printing before retiring
-		unsigned int get_sequence_for_entry(unsigned int rob_tag){
-            return rob[rob_tag].get_sequence();
+            num_valid_entries--;
+            clear_bit(valid_bits, rob_tag);
         }
 
+        //number of occupied entries
+		unsigned int get_num_valid_entries(){
+            return num_valid_entries;
+        }
+		
         //useful for updating RMT when retiring the instruction
         int get_arf_dst(unsigned int rob_tag){
-            return rob[rob_tag].get_arf_dst();
+            return arf_dst[rob_tag];
+        }
+
+        //store the instruction record in its rob slot. used by the dispatch stage
+        void set_instr(unsigned int rob_tag, instruction& instr){
+            rob_instrs[rob_tag] = instr;
+        }
+        //get the in-flight instruction for a rob tag
+        //issue, execute, writeback and retire reach the instruction in O(1) through this
+        instruction& get_instr(unsigned int rob_tag){
+            return rob_instrs[rob_tag];
         }
 		
 		void display_rob();
@@ -182,24 +154,26 @@ void rob::rob_initialize(unsigned int rob_size, unsigned int width)
     //set the size of the rob
 	this->rob_size = rob_size;
     //create the number of enteries in the rob based on the size
-	rob.resize(rob_size);
+	arf_dst.assign(rob_size, -1);
+	rob_instrs.resize(rob_size);
 
     //point head and tail at the same index. let's say 0
     rob_head = 0;
 	rob_tail = 0; 
+	num_valid_entries = 0;
 
     //width of the pipeline for rob retire
 	pipeline_width_for_rob_retire = width;
     //clear all the valid bits at the start of simulation to ensure all the rob enteries
     //are available to be written
     //rest of the bits dont matter if valid = 0
-	for(int i = 0; i < (int) rob_size; i++){
-		rob[i].clear_valid_bit();
-    }
+	valid_bits.assign((rob_size + 63) / 64, 0);
+	ready_bits.assign((rob_size + 63) / 64, 0);
 }
 
 
-unsigned int rob::allocate_rob_entry(unsigned long pc_val, int dst_val, unsigned int seq)
+template<unsigned int ROB_SIZE>
+unsigned int rob::allocate_rob_entry(int dst_val)
 {
 	//assign the previous tail index before incrementing 
     //the previous value is stored in rmt
@@ -207,52 +181,45 @@ unsigned int rob::allocate_rob_entry(unsigned long pc_val, int dst_val, unsigned
 
     //allocating blindly. call this function only if the rob is not full
     //creating cyclic buffer of rob size
-	if(prev_tail_index == (rob_size - 1))
-		set_tail(0);
-	else
-        //point to next index
-		set_tail(rob_tail++);
+	set_tail(next_tag<ROB_SIZE>(rob_tail));
 	
     //set all the required metadatas for the rob entry
-	rob[prev_tail_index].set_rob_index(prev_tail_index);
-	rob[prev_tail_index].set_valid_bit();
-	rob[prev_tail_index].set_arf_dst(dst_val);
-	rob[prev_tail_index].clear_ready_bit();
-	rob[prev_tail_index].set_sequence(seq);
-	rob[prev_tail_index].set_pc(pc_val);
+	set_bit(valid_bits, prev_tail_index);
+	num_valid_entries++;
+	arf_dst[prev_tail_index] = dst_val;
+	clear_bit(ready_bits, prev_tail_index);
 
 	return prev_tail_index;
 }
 
 void rob::display_rob()
 {
-	int robsize = rob.size();
 	printf("\n=================ROB Contents=================\n");
 	printf("\tHead = %u, Tail = %u", rob_head, rob_tail);
-	for(int i = 0; i < robsize; i++)
+	for(int i = 0; i < (int) rob_size; i++)
 	{
-		rob[i].display_line();
+		//the sequence number is only known once the instruction is dispatched
+		printf("\n\tindex: %d\tdst: %d\trdy: %d\tv: %d\tseq: %" PRIu64, i, arf_dst[i], test_bit(ready_bits, i), test_bit(valid_bits, i), rob_instrs[i].get_sequence());
 	}
 	cout << endl;
 }
 
+template<unsigned int WIDTH, unsigned int ROB_SIZE>
 bool rob::check_width_amount_free_entries()
 {
 	unsigned int entries_free = 1;
 	bool allow_push = false;
 	unsigned int local_tail = rob_tail;
+	const unsigned int width = WIDTH ? WIDTH : pipeline_width_for_rob_retire;
 
-	for(int i = 0; i < (int) pipeline_width_for_rob_retire; i++)
+	for(int i = 0; i < (int) width; i++)
 	{
-		if(rob[local_tail].get_valid_bit() == false)
+		if(test_bit(valid_bits, local_tail) == false)
 			entries_free &= 1;
 		else
 			entries_free &= 0;
 
-		if(local_tail == rob_size - 1)
-			local_tail = 0;
-		else
-			local_tail++;
+		local_tail = next_tag<ROB_SIZE>(local_tail);
 	}
 	if(entries_free)
 	{
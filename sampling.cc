@@ -0,0 +1,589 @@
+//sampled simulation of long traces
+//only a few regions of the trace are simulated in detail, everything else is
+//fast-forwarded. the pipeline is drained at a fast-forwarded point: every
+//register is in the ARF and the RMT maps nothing, so fast-forwarding only has
+//to skip the records. the pipeline itself (ROB, IQ, latches) is warmed up by
+//simulating --warmup instructions in detail before every region
+//
+//a text trace is never read into memory as a whole. a binary trace (or an up
+//to date .bin sidecar) is mapped, a text trace is parsed once per pass over it
+//and only the records of the region being simulated are kept
+//
+//SimPoint (--simpoint): the trace is cut into intervals, every interval gets a
+//basic block vector, the vectors are clustered with k-means and the interval
+//closest to the centre of every cluster is simulated. the IPC of the trace is
+//the CPI of those intervals weighted by the size of their cluster
+//
+//SMARTS (--smarts): short units spread evenly over the trace are simulated and
+//the CPI of the trace is estimated from their mean. the sampling gets denser
+//(the period halves) until the confidence interval of the mean is within the
+//target error, so the error is bounded without simulating the whole trace
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <math.h>
+
+#include <vector>
+#include <algorithm>
+
+#include "sim_proc.h"
+
+//dimensions the basic block vectors are hashed down to
+#define SIMPOINT_DIMS 32
+
+//records read per call while streaming through the trace
+#define SAMPLE_CHUNK 1024
+
+//the trace seen by the sampling, as a number of passes from start to end
+class sample_source
+{
+	private:
+		trace_reader *trace;
+		const char *trace_file;
+		bool prefetch;
+        //binary trace, NULL for a text trace
+		const trace_record *mapped;
+		uint64_t num_mapped;
+        //passes started so far
+		unsigned int passes;
+        //records consumed in the current pass
+		uint64_t next_record;
+        //text trace: records [window_first, window_first + window.size())
+		vector<trace_record> window;
+		uint64_t window_first;
+
+	public:
+		void sample_source_initialize(trace_reader *trace, const char *trace_file, sim_options *opts);
+
+        //starts over at the first record, a text trace is opened again
+		void start_pass();
+        //next records of the current pass, returns 0 at the end of the trace
+		unsigned int read(trace_record *recs, unsigned int max);
+        //records in the trace, a text trace takes a pass to count them
+		uint64_t count_records();
+        //records [first, first + count) of the trace. within a pass the
+        //regions have to move forward (first never goes back)
+		const trace_record *get_region(uint64_t first, uint64_t count);
+};
+
+void sample_source::sample_source_initialize(trace_reader *trace, const char *trace_file, sim_options *opts)
+{
+	this->trace = trace;
+	this->trace_file = trace_file;
+	prefetch = opts->prefetch_trace;
+	mapped = trace->get_records(&num_mapped);
+	passes = 0;
+	next_record = 0;
+	window_first = 0;
+}
+
+void sample_source::start_pass()
+{
+	//the trace was opened for the first pass by the caller
+	if(mapped == NULL && passes != 0)
+	{
+		if(strcmp(trace_file, "-") == 0)
+		{
+			printf("Error: --simpoint and --smarts read the trace more than once, not from stdin (convert it with ./trace2bin first)\n");
+			exit(EXIT_FAILURE);
+		}
+		trace->trace_close();
+		if(!trace->trace_open(trace_file, false, prefetch))
+		{
+			printf("Error: Unable to open file %s\n", trace_file);
+			exit(EXIT_FAILURE);
+		}
+	}
+	passes++;
+	next_record = 0;
+	window.clear();
+	window_first = 0;
+}
+
+unsigned int sample_source::read(trace_record *recs, unsigned int max)
+{
+	unsigned int n;
+	if(mapped != NULL)
+	{
+		n = (unsigned int) std::min((uint64_t) max, num_mapped - next_record);
+		std::copy(mapped + next_record, mapped + next_record + n, recs);
+	}
+	else
+		n = trace->read_instrs(recs, max);
+	next_record += n;
+	return n;
+}
+
+uint64_t sample_source::count_records()
+{
+	if(mapped != NULL)
+		return num_mapped;
+	trace_record chunk[SAMPLE_CHUNK];
+	start_pass();
+	while(read(chunk, SAMPLE_CHUNK) != 0)
+		;
+	return next_record;
+}
+
+const trace_record *sample_source::get_region(uint64_t first, uint64_t count)
+{
+	if(mapped != NULL)
+		return mapped + first;
+
+	//drop what is before the region, a region can overlap the one before it
+	if(first > window_first)
+	{
+		uint64_t drop = std::min(first - window_first, (uint64_t) window.size());
+		window.erase(window.begin(), window.begin() + drop);
+		window_first += drop;
+	}
+	//skip up to the region and read the rest of it
+	trace_record chunk[SAMPLE_CHUNK];
+	while(next_record < first)
+	{
+		unsigned int n = read(chunk, (unsigned int) std::min((uint64_t) SAMPLE_CHUNK, first - next_record));
+		if(n == 0)
+			break;
+	}
+	if(window.empty())
+		window_first = next_record;
+	while(window_first + window.size() < first + count)
+	{
+		unsigned int n = read(chunk, (unsigned int) std::min((uint64_t) SAMPLE_CHUNK, first + count - window_first - window.size()));
+		if(n == 0)
+		{
+			printf("Error: Trace %s changed while it was sampled\n", trace_file);
+			exit(EXIT_FAILURE);
+		}
+		window.insert(window.end(), chunk, chunk + n);
+	}
+	return &window[first - window_first];
+}
+
+//simulates the warm + count records of a region on an empty pipeline and
+//returns the cycles the last count of them took
+//a region at the start of the trace gets less warmup (the real start is cold too)
+uint64_t measure_region(proc_params *params, sim_options *opts, const trace_record *recs, uint64_t warm, uint64_t count)
+{
+	trace_reader trace;
+	trace.trace_open_records(recs, warm + count);
+
+	simulator *sim = new simulator;
+	if(!sim->simulator_initialize(params, opts, &trace, false))
+	{
+		printf("Error: Unable to create file %s\n", sim->get_failed_file());
+		exit(EXIT_FAILURE);
+	}
+	//the region starts in the cycle after the last warmup instruction retired
+	pipeline_data *m_data = sim->get_pipeline_data();
+	uint64_t start_cycle = 0;
+	if(warm != 0)
+	{
+		while(!sim->step() && m_data->num_retired < warm)
+			;
+		start_cycle = m_data->simulation_cycle;
+	}
+	sim->run_to_end();
+	uint64_t cycles = m_data->simulation_cycle - start_cycle;
+	sim->simulator_close();
+	delete sim;
+	return cycles;
+}
+
+//small deterministic generator for the k-means seeding, so runs are repeatable
+static uint64_t kmeans_state;
+static double kmeans_rand()
+{
+	kmeans_state = kmeans_state * 6364136223846793005ull + 1442695040888963407ull;
+	return (double) (kmeans_state >> 11) / (double) (1ull << 53);
+}
+
+//one basic block vector per interval, SIMPOINT_DIMS values each, from one
+//pass over the trace. returns the number of records
+//a basic block starts wherever the pc does not follow the previous one
+//every instruction counts for the block it is in, the block start pc is
+//hashed to a dimension and every vector is normalised to sum up to 1
+uint64_t collect_bbvs(sample_source *src, uint64_t interval, vector<double>& bbvs)
+{
+	bbvs.clear();
+	uint64_t num_recs = 0;
+	uint64_t block_pc = 0, last_pc = 0;
+	trace_record chunk[SAMPLE_CHUNK];
+	unsigned int n;
+	src->start_pass();
+	while((n = src->read(chunk, SAMPLE_CHUNK)) != 0)
+	{
+		for(unsigned int j = 0; j < n; j++, num_recs++)
+		{
+			if(num_recs == 0 || chunk[j].pc != last_pc + 4)
+				block_pc = chunk[j].pc;
+			last_pc = chunk[j].pc;
+			if(num_recs % interval == 0)
+				bbvs.resize(bbvs.size() + SIMPOINT_DIMS, 0.0);
+			uint64_t dim = (block_pc * 0x9e3779b97f4a7c15ull) >> 59;
+			bbvs[(num_recs / interval) * SIMPOINT_DIMS + dim] += 1.0;
+		}
+	}
+	if(num_recs == 0)
+		return 0;
+	uint64_t num_intervals = bbvs.size() / SIMPOINT_DIMS;
+	for(uint64_t v = 0; v < num_intervals; v++)
+	{
+		uint64_t len = std::min(interval, num_recs - v * interval);
+		for(int d = 0; d < SIMPOINT_DIMS; d++)
+			bbvs[v * SIMPOINT_DIMS + d] /= len;
+	}
+	return num_recs;
+}
+
+static double bbv_distance(const double *a, const double *b)
+{
+	double sum = 0.0;
+	for(int d = 0; d < SIMPOINT_DIMS; d++)
+		sum += (a[d] - b[d]) * (a[d] - b[d]);
+	return sum;
+}
+
+//k-means (k-means++ seeding, then Lloyd iterations) of n vectors
+//leaves the cluster of every vector in assign and returns the sum of the
+//squared distances to the centres
+double kmeans(const vector<double>& bbvs, uint64_t n, unsigned int k, vector<int>& assign, vector<double>& centres)
+{
+	kmeans_state = 0x9e3779b97f4a7c15ull + k;
+	centres.assign(k * SIMPOINT_DIMS, 0.0);
+	assign.assign(n, 0);
+
+	//k-means++: every next centre is picked with probability proportional to
+	//the squared distance to the closest centre so far
+	vector<double> closest(n, HUGE_VAL);
+	uint64_t pick = (uint64_t) (kmeans_rand() * n);
+	for(unsigned int c = 0; c < k; c++)
+	{
+		std::copy(&bbvs[pick * SIMPOINT_DIMS], &bbvs[pick * SIMPOINT_DIMS] + SIMPOINT_DIMS, &centres[c * SIMPOINT_DIMS]);
+		double total = 0.0;
+		for(uint64_t v = 0; v < n; v++)
+		{
+			closest[v] = std::min(closest[v], bbv_distance(&bbvs[v * SIMPOINT_DIMS], &centres[c * SIMPOINT_DIMS]));
+			total += closest[v];
+		}
+		double target = kmeans_rand() * total;
+		pick = 0;
+		for(uint64_t v = 0; v < n; v++)
+		{
+			target -= closest[v];
+			if(target <= 0.0)
+			{
+				pick = v;
+				break;
+			}
+		}
+	}
+
+	double sse = 0.0;
+	for(int iter = 0; iter < 100; iter++)
+	{
+		bool changed = false;
+		sse = 0.0;
+		for(uint64_t v = 0; v < n; v++)
+		{
+			int best = 0;
+			double best_dist = HUGE_VAL;
+			for(unsigned int c = 0; c < k; c++)
+			{
+				double dist = bbv_distance(&bbvs[v * SIMPOINT_DIMS], &centres[c * SIMPOINT_DIMS]);
+				if(dist < best_dist)
+				{
+					best = c;
+					best_dist = dist;
+				}
+			}
+			if(assign[v] != best)
+				changed = true;
+			assign[v] = best;
+			sse += best_dist;
+		}
+		if(!changed && iter != 0)
+			break;
+
+		//move every centre to the mean of its vectors (empty clusters stay put)
+		vector<uint64_t> members(k, 0);
+		vector<double> sums(k * SIMPOINT_DIMS, 0.0);
+		for(uint64_t v = 0; v < n; v++)
+		{
+			members[assign[v]]++;
+			for(int d = 0; d < SIMPOINT_DIMS; d++)
+				sums[assign[v] * SIMPOINT_DIMS + d] += bbvs[v * SIMPOINT_DIMS + d];
+		}
+		for(unsigned int c = 0; c < k; c++)
+			if(members[c] != 0)
+				for(int d = 0; d < SIMPOINT_DIMS; d++)
+					centres[c * SIMPOINT_DIMS + d] = sums[c * SIMPOINT_DIMS + d] / members[c];
+	}
+	return sse;
+}
+
+//bayesian information criterion of a clustering (as in x-means and SimPoint)
+//higher is better, it trades the likelihood against the number of clusters
+double kmeans_bic(uint64_t n, unsigned int k, vector<int>& assign, double sse)
+{
+	if(n <= k)
+		return 0.0;
+	double variance = std::max(sse / (double) (n - k), 1e-12);
+	vector<uint64_t> members(k, 0);
+	for(uint64_t v = 0; v < n; v++)
+		members[assign[v]]++;
+	double likelihood = 0.0;
+	for(unsigned int c = 0; c < k; c++)
+	{
+		double r = members[c];
+		if(r == 0)
+			continue;
+		likelihood += r * log(r) - r * log((double) n) - r / 2.0 * log(2.0 * M_PI) - r * SIMPOINT_DIMS / 2.0 * log(variance) - (r - 1) / 2.0;
+	}
+	double params = (k - 1) + (double) k * SIMPOINT_DIMS + 1;
+	return likelihood - params / 2.0 * log((double) n);
+}
+
+//one simulation point: an interval and the share of the trace it stands for
+typedef struct simpoint{
+	uint64_t interval;
+	uint64_t first;
+	uint64_t count;
+	double weight;
+	uint64_t cycles;
+}simpoint;
+
+//clusters the intervals of the vectors of num_recs records and picks one
+//simulation point per cluster
+//k goes from 1 to max_k, the smallest k whose BIC reaches 90% of the range
+//of BIC scores is used (the SimPoint rule)
+void pick_simpoints(vector<double>& bbvs, uint64_t num_recs, uint64_t interval, unsigned int max_k, vector<simpoint>& points)
+{
+	uint64_t n = bbvs.size() / SIMPOINT_DIMS;
+	if(max_k > n)
+		max_k = n;
+
+	vector< vector<int> > assigns(max_k + 1);
+	vector< vector<double> > centres(max_k + 1);
+	vector<double> bic(max_k + 1);
+	double bic_min = HUGE_VAL, bic_max = -HUGE_VAL;
+	for(unsigned int k = 1; k <= max_k; k++)
+	{
+		double sse = kmeans(bbvs, n, k, assigns[k], centres[k]);
+		bic[k] = kmeans_bic(n, k, assigns[k], sse);
+		bic_min = std::min(bic_min, bic[k]);
+		bic_max = std::max(bic_max, bic[k]);
+	}
+	unsigned int k = 1;
+	while(k < max_k && bic[k] < bic_min + 0.9 * (bic_max - bic_min))
+		k++;
+
+	//the interval closest to the centre stands for the whole cluster, weighted
+	//by the instructions of the cluster (the last interval can be short)
+	points.clear();
+	for(unsigned int c = 0; c < k; c++)
+	{
+		simpoint p;
+		double best_dist = HUGE_VAL;
+		uint64_t instrs = 0;
+		for(uint64_t v = 0; v < n; v++)
+		{
+			if(assigns[k][v] != (int) c)
+				continue;
+			instrs += std::min(interval, num_recs - v * interval);
+			double dist = bbv_distance(&bbvs[v * SIMPOINT_DIMS], &centres[k][c * SIMPOINT_DIMS]);
+			if(dist < best_dist)
+			{
+				best_dist = dist;
+				p.interval = v;
+			}
+		}
+		if(instrs == 0)
+			continue;
+		p.first = p.interval * interval;
+		p.count = std::min(interval, num_recs - p.first);
+		p.weight = (double) instrs / num_recs;
+		p.cycles = 0;
+		points.push_back(p);
+	}
+}
+
+typedef struct simpoint_result{
+	uint64_t instructions;
+	uint64_t intervals;
+	uint64_t interval;
+	vector<simpoint> points;
+	//instructions simulated in detail, warmup included
+	uint64_t simulated;
+	//estimated cycles of the whole trace
+	uint64_t cycles;
+}simpoint_result;
+
+bool compare_simpoints(const simpoint& a, const simpoint& b)
+{
+	return a.first < b.first;
+}
+
+//picks the simulation points of the trace and simulates them
+//one pass over the trace for the vectors, one for the simulation points
+void run_simpoint(proc_params *params, sim_options *opts, trace_reader *trace, const char *trace_file, simpoint_result *result)
+{
+	sample_source src;
+	src.sample_source_initialize(trace, trace_file, opts);
+	vector<double> bbvs;
+	uint64_t num_recs = collect_bbvs(&src, opts->simpoint_interval, bbvs);
+	if(num_recs == 0)
+	{
+		printf("Error: Empty trace %s\n", trace_file);
+		exit(EXIT_FAILURE);
+	}
+
+	vector<simpoint>& points = result->points;
+	pick_simpoints(bbvs, num_recs, opts->simpoint_interval, opts->simpoint_max_k, points);
+	//in trace order, the fast-forwards then only go forward
+	std::sort(points.begin(), points.end(), compare_simpoints);
+	src.start_pass();
+
+	double cpi = 0.0;
+	uint64_t simulated = 0;
+	for(int i = 0; i < (int) points.size(); i++)
+	{
+		simpoint& p = points[i];
+		uint64_t warm = std::min(opts->warmup, p.first);
+		p.cycles = measure_region(params, opts, src.get_region(p.first - warm, warm + p.count), warm, p.count);
+		cpi += p.weight * p.cycles / p.count;
+		simulated += p.count + warm;
+	}
+	result->instructions = num_recs;
+	result->interval = opts->simpoint_interval;
+	result->intervals = (num_recs + opts->simpoint_interval - 1) / opts->simpoint_interval;
+	result->simulated = simulated;
+	result->cycles = (uint64_t) (cpi * num_recs + 0.5);
+}
+
+//the simulation points, printed before the usual summary
+void print_simpoint_result(simpoint_result *result)
+{
+	vector<simpoint>& points = result->points;
+	printf("# === SimPoint ==================\n");
+	printf("# Intervals                    = %" PRIu64 " x %" PRIu64 " instructions\n", result->intervals, result->interval);
+	printf("# Simulation Points            = %d\n", (int) points.size());
+	for(int i = 0; i < (int) points.size(); i++)
+		printf("#   interval %" PRIu64 " (instructions %" PRIu64 "-%" PRIu64 ") weight %.4lf IPC %.2lf\n", points[i].interval, points[i].first, points[i].first + points[i].count - 1, points[i].weight, (double) points[i].count / points[i].cycles);
+	printf("# Simulated Instructions       = %" PRIu64 " (%.2lf%% of the trace, with warmup)\n", result->simulated, 100.0 * result->simulated / result->instructions);
+}
+
+//fewest samples before the confidence interval is trusted
+#define SMARTS_MIN_SAMPLES 30
+
+typedef struct smarts_result{
+	uint64_t instructions;
+	uint64_t unit;
+	uint64_t samples;
+	//units between two samples in the last round
+	uint64_t period;
+	uint64_t simulated;
+	double cpi;
+	//half width of the confidence interval, relative to the cpi
+	double error;
+	bool reached;
+	uint64_t cycles;
+}smarts_result;
+
+//z of a two sided confidence level of the normal distribution, e.g. 3.0 for 0.997
+double confidence_z(double confidence)
+{
+	double lo = 0.0, hi = 10.0;
+	for(int i = 0; i < 100; i++)
+	{
+		double mid = (lo + hi) / 2.0;
+		if(erf(mid / sqrt(2.0)) < confidence)
+			lo = mid;
+		else
+			hi = mid;
+	}
+	return (lo + hi) / 2.0;
+}
+
+//simulates units of --smarts-unit instructions, every period-th unit of the
+//trace. starts with at least SMARTS_MIN_SAMPLES samples and halves the period
+//(adding the units half way between the ones already simulated) until the
+//confidence interval is within --smarts-error or every unit is simulated
+//every round is one pass over the trace, its units are in trace order
+void run_smarts(proc_params *params, sim_options *opts, trace_reader *trace, const char *trace_file, smarts_result *result)
+{
+	sample_source src;
+	src.sample_source_initialize(trace, trace_file, opts);
+	uint64_t num_recs = src.count_records();
+	if(num_recs == 0)
+	{
+		printf("Error: Empty trace %s\n", trace_file);
+		exit(EXIT_FAILURE);
+	}
+
+	uint64_t unit = std::min(opts->smarts_unit, num_recs);
+	uint64_t num_units = num_recs / unit;
+	//a power of two, so every round splits the gaps of the one before exactly
+	uint64_t period = 1;
+	while(period * 2 * SMARTS_MIN_SAMPLES <= num_units)
+		period *= 2;
+	double z = confidence_z(opts->smarts_confidence / 100.0);
+
+	double sum = 0.0, sum_sq = 0.0;
+	uint64_t n = 0;
+	result->simulated = 0;
+	result->reached = false;
+	//the first round takes units 0, period, 2 * period, ...
+	//every later round the units in the middle of those gaps
+	uint64_t first = 0, step = period;
+	while(true)
+	{
+		src.start_pass();
+		for(uint64_t u = first; u < num_units; u += step)
+		{
+			uint64_t warm = std::min(opts->warmup, u * unit);
+			double cpi = (double) measure_region(params, opts, src.get_region(u * unit - warm, warm + unit), warm, unit) / unit;
+			sum += cpi;
+			sum_sq += cpi * cpi;
+			n++;
+			result->simulated += unit + warm;
+		}
+		double mean = sum / n;
+		double variance = n > 1 ? std::max((sum_sq - n * mean * mean) / (n - 1), 0.0) : 0.0;
+		result->cpi = mean;
+		result->error = z * sqrt(variance / n) / mean;
+		result->period = period;
+		if(n >= SMARTS_MIN_SAMPLES && result->error * 100.0 <= opts->smarts_error)
+		{
+			result->reached = true;
+			break;
+		}
+		if(period == 1)
+			break;
+		period /= 2;
+		first = period;
+		step = period * 2;
+	}
+	result->instructions = num_recs;
+	result->unit = unit;
+	result->samples = n;
+	result->cycles = (uint64_t) (result->cpi * num_recs + 0.5);
+}
+
+//the sampling and the confidence interval, printed before the usual summary
+void print_smarts_result(smarts_result *result, sim_options *opts)
+{
+	printf("# === SMARTS ====================\n");
+	printf("# Sampling Unit                = %" PRIu64 " instructions\n", result->unit);
+	printf("# Samples                      = %" PRIu64 " (one every %" PRIu64 " units)\n", result->samples, result->period);
+	printf("# Simulated Instructions       = %" PRIu64 " (%.2lf%% of the trace, with warmup)\n", result->simulated, 100.0 * result->simulated / result->instructions);
+	if(result->simulated > result->instructions)
+		printf("# Warning: more than the whole trace was simulated, a full simulation is faster (lower --warmup)\n");
+	printf("# CPI                          = %.4lf +- %.2lf%% (%.1lf%% confidence)\n", result->cpi, 100.0 * result->error, opts->smarts_confidence);
+	if(result->reached)
+		printf("# Target Error                 = +- %.2lf%% reached\n", opts->smarts_error);
+	else
+		printf("# Target Error                 = +- %.2lf%% not reached, every unit was simulated\n", opts->smarts_error);
+}
@@ -4,7 +4,11 @@
 #include <inttypes.h>
 #include "sim_proc.h"
 
-#include "pipeline_stages.cc"
+#include "simulator.cc"
+#include "interval_model.cc"
+#include "sampling.cc"
+#include "sweep.cc"
+#include "dataflow.cc"
 
 
 /*  argc holds the number of command line arguments
@@ -17,88 +21,392 @@
     argv[1] = "256"
     argv[2] = "32"
     ... and so on
+
+    Design space sweep:-
+    sim 64,128,256 16,32 2,4,8 gcc_trace.txt --threads 8
+    simulates all 18 combinations on 8 threads and prints one CSV row each
+
+    Optional settings can follow the trace file:-
+    --no-cycle-skip     evaluate every stage in every cycle
+    --no-specialize     always run the generic pipeline, not the one compiled
+                        for the configuration
+    --no-binary-trace   always parse the text trace, even if a fresh
+                        <trace_file>.bin sidecar exists
+    --prefetch-trace    parse a text trace on a separate thread ahead of
+                        the simulation
+    --quiet             only print the summary, no per-instruction timing
+    --print-range F:L   only print the instructions with sequence numbers F to L
+    --timing-log FILE   also write the per-instruction timing to FILE in the
+                        binary format of timing_log.h (tool/scope reads it)
+    --stats             after the summary, print the cycles every stage stalled
+                        (by cause) and the ROB and IQ occupancy histograms
+    --interval-log FILE write IPC, mean ROB/IQ occupancy and stall cycles of
+                        every interval to FILE as CSV
+    --interval N        intervals of N cycles (default 10000)
+    --interval-instrs N intervals of N retired instructions instead
+    --dataflow          skip the pipeline, only report the dataflow limited IPC
+                        (critical path) for an infinite machine and for WIDTH
+    --model             skip the pipeline, estimate the cycles with the interval
+                        model (interval_model.cc). also works for sweeps
+    --model-check       simulate the pipeline and report the error of the
+                        interval model against it
+    --simpoint          only simulate the SimPoint simulation points of the trace
+                        and report their weighted IPC (sampling.cc)
+    --simpoint-interval N
+                        instructions per interval (default 100000)
+    --simpoint-k K      most clusters to try (default 10)
+    --smarts            simulate short units spread over the trace until the IPC
+                        is known within a target error (sampling.cc)
+    --smarts-unit N     instructions per unit (default 1000)
+    --smarts-error E    target error in percent of the CPI (default 1)
+    --smarts-confidence C
+                        confidence level of the target in percent (default 99.7)
+    --warmup N          instructions simulated before every sampled region to
+                        warm the pipeline up (default 10000, with --smarts
+                        two units)
+    --async-output      write the per-instruction log from a separate thread
+    --sweep             print the CSV rows of a sweep even for one configuration
+    --threads N         threads used by a sweep (default: one per hardware thread)
+
+    The trace file "-" reads the trace from stdin
 */
 
-bool Advance_Cycle(pipeline_data *meta)
+//parse the optional settings that follow the trace file
+void parse_options(int argc, char* argv[], sim_options *opts)
+{
+	//defaults
+	opts->cycle_skip = true;
+	opts->specialize = true;
+	opts->binary_sidecar = true;
+	opts->prefetch_trace = false;
+	opts->async_output = false;
+	opts->quiet = false;
+	opts->stats = false;
+	opts->dataflow = false;
+	opts->model = false;
+	opts->model_check = false;
+	opts->simpoint = false;
+	opts->simpoint_interval = 100000;
+	opts->simpoint_max_k = 10;
+	opts->smarts = false;
+	opts->smarts_unit = 1000;
+	opts->smarts_error = 1.0;
+	opts->smarts_confidence = 99.7;
+	opts->warmup = 10000;
+	opts->interval_log_file = NULL;
+	opts->interval_cycles = 10000;
+	opts->interval_instrs = 0;
+	opts->print_range_first = 0;
+	opts->print_range_last = UINT64_MAX;
+	opts->timing_log_file = NULL;
+	opts->sweep = false;
+	opts->sweep_threads = 0;
+	bool warmup_given = false;
+
+	for(int i = 5; i < argc; i++)
+	{
+		if(strcmp(argv[i], "--no-cycle-skip") == 0)
+			opts->cycle_skip = false;
+		else if(strcmp(argv[i], "--no-specialize") == 0)
+			opts->specialize = false;
+		else if(strcmp(argv[i], "--no-binary-trace") == 0)
+			opts->binary_sidecar = false;
+		else if(strcmp(argv[i], "--prefetch-trace") == 0)
+			opts->prefetch_trace = true;
+		else if(strcmp(argv[i], "--dataflow") == 0)
+			opts->dataflow = true;
+		else if(strcmp(argv[i], "--model") == 0)
+			opts->model = true;
+		else if(strcmp(argv[i], "--model-check") == 0)
+			opts->model_check = true;
+		else if(strcmp(argv[i], "--simpoint") == 0)
+			opts->simpoint = true;
+		else if(strcmp(argv[i], "--simpoint-interval") == 0 && i + 1 < argc)
+		{
+			opts->simpoint_interval = strtoull(argv[++i], NULL, 10);
+			if(opts->simpoint_interval == 0)
+			{
+				printf("Error: Invalid interval %s\n", argv[i]);
+				exit(EXIT_FAILURE);
+			}
+		}
+		else if(strcmp(argv[i], "--simpoint-k") == 0 && i + 1 < argc)
+		{
+			opts->simpoint_max_k = strtoul(argv[++i], NULL, 10);
+			if(opts->simpoint_max_k == 0)
+			{
+				printf("Error: Invalid cluster count %s\n", argv[i]);
+				exit(EXIT_FAILURE);
+			}
+		}
+		else if(strcmp(argv[i], "--smarts") == 0)
+			opts->smarts = true;
+		else if(strcmp(argv[i], "--smarts-unit") == 0 && i + 1 < argc)
+		{
+			opts->smarts_unit = strtoull(argv[++i], NULL, 10);
+			if(opts->smarts_unit == 0)
+			{
+				printf("Error: Invalid unit %s\n", argv[i]);
+				exit(EXIT_FAILURE);
+			}
+		}
+		else if(strcmp(argv[i], "--smarts-error") == 0 && i + 1 < argc)
+		{
+			opts->smarts_error = strtod(argv[++i], NULL);
+			if(opts->smarts_error <= 0.0)
+			{
+				printf("Error: Invalid error %s\n", argv[i]);
+				exit(EXIT_FAILURE);
+			}
+		}
+		else if(strcmp(argv[i], "--smarts-confidence") == 0 && i + 1 < argc)
+		{
+			opts->smarts_confidence = strtod(argv[++i], NULL);
+			if(opts->smarts_confidence <= 0.0 || opts->smarts_confidence >= 100.0)
+			{
+				printf("Error: Invalid confidence %s\n", argv[i]);
+				exit(EXIT_FAILURE);
+			}
+		}
+		else if(strcmp(argv[i], "--warmup") == 0 && i + 1 < argc)
+		{
+			opts->warmup = strtoull(argv[++i], NULL, 10);
+			warmup_given = true;
+		}
+		else if(strcmp(argv[i], "--stats") == 0)
+			opts->stats = true;
+		else if(strcmp(argv[i], "--interval-log") == 0 && i + 1 < argc)
+			opts->interval_log_file = argv[++i];
+		else if(strcmp(argv[i], "--interval") == 0 && i + 1 < argc)
+		{
+			opts->interval_cycles = strtoull(argv[++i], NULL, 10);
+			if(opts->interval_cycles == 0)
+			{
+				printf("Error: Invalid interval %s\n", argv[i]);
+				exit(EXIT_FAILURE);
+			}
+		}
+		else if(strcmp(argv[i], "--interval-instrs") == 0 && i + 1 < argc)
+		{
+			opts->interval_instrs = strtoull(argv[++i], NULL, 10);
+			if(opts->interval_instrs == 0)
+			{
+				printf("Error: Invalid interval %s\n", argv[i]);
+				exit(EXIT_FAILURE);
+			}
+		}
+		else if(strcmp(argv[i], "--quiet") == 0)
+			opts->quiet = true;
+		else if(strcmp(argv[i], "--print-range") == 0 && i + 1 < argc)
+		{
+			char *colon;
+			char *end;
+			const char *range = argv[++i];
+			opts->print_range_first = strtoull(range, &colon, 10);
+			if(colon == range || *colon != ':')
+			{
+				printf("Error: Invalid print range %s\n", range);
+				exit(EXIT_FAILURE);
+			}
+			opts->print_range_last = strtoull(colon + 1, &end, 10);
+			if(end == colon + 1 || *end != '\0' || opts->print_range_last < opts->print_range_first)
+			{
+				printf("Error: Invalid print range %s\n", range);
+				exit(EXIT_FAILURE);
+			}
+		}
+		else if(strcmp(argv[i], "--timing-log") == 0 && i + 1 < argc)
+			opts->timing_log_file = argv[++i];
+		else if(strcmp(argv[i], "--async-output") == 0)
+			opts->async_output = true;
+		else if(strcmp(argv[i], "--sweep") == 0)
+			opts->sweep = true;
+		else if(strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+			opts->sweep_threads = strtoul(argv[++i], NULL, 10);
+		else
+		{
+			printf("Error: Unknown option %s\n", argv[i]);
+			exit(EXIT_FAILURE);
+		}
+	}
+	//SimPoint simulates few long intervals, SMARTS many short units. the
+	//SimPoint warmup would make every SMARTS sample cost 11 units
+	if(opts->smarts && !warmup_given)
+		opts->warmup = 2 * opts->smarts_unit;
+}
+
+//the command and configuration lines that start every summary
+void print_configuration(proc_params *params, const char *trace_file)
 {
-	meta->simulation_cycle++;
-	return meta->is_simulation_done;
+	printf("# === Simulator Command =========\n");
+	printf("# ./sim %lu %lu %lu %s\n", params->rob_size, params->iq_size, params->width, trace_file);
+	printf("# === Processor Configuration ===\n");
+	printf("# ROB_SIZE = %lu\n", params->rob_size);
+	printf("# IQ_SIZE  = %lu\n", params->iq_size);
+	printf("# WIDTH    = %lu\n", params->width);
 }
 
 int main (int argc, char* argv[])
 {
-    FILE *FP;               // File handler
+    trace_reader trace;     // Reads the text or binary trace
     char *trace_file;       // Variable that holds trace file name;
     proc_params params;       // look at sim_bp.h header file for the the definition of struct proc_params
+    sim_options opts;         // optional settings after the trace file
     
-    if (argc != 5)
+    if (argc < 5)
     {
         printf("Error: Wrong number of inputs:%d\n", argc-1);
         exit(EXIT_FAILURE);
     }
     
+    trace_file          = argv[4];
+    parse_options(argc, argv, &opts);
+
+    // every size can be a comma separated list, which turns the run into a sweep
+    vector<unsigned long> rob_sizes, iq_sizes, widths;
+    bool is_sweep = opts.sweep || strchr(argv[1], ',') || strchr(argv[2], ',') || strchr(argv[3], ',');
+    if(is_sweep && opts.dataflow)
+    {
+        printf("Error: --dataflow needs a single configuration\n");
+        exit(EXIT_FAILURE);
+    }
+    if(is_sweep && (opts.model_check || opts.simpoint || opts.smarts))
+    {
+        printf("Error: --model-check, --simpoint and --smarts need a single configuration\n");
+        exit(EXIT_FAILURE);
+    }
+    if((opts.simpoint || opts.smarts) && (opts.timing_log_file != NULL || opts.interval_log_file != NULL || opts.stats))
+    {
+        printf("Error: --timing-log, --interval-log and --stats need a full simulation\n");
+        exit(EXIT_FAILURE);
+    }
+    if(is_sweep && (opts.timing_log_file != NULL || opts.interval_log_file != NULL))
+    {
+        printf("Error: --timing-log and --interval-log need a single configuration\n");
+        exit(EXIT_FAILURE);
+    }
+    if(is_sweep)
+    {
+        parse_size_list(argv[1], "ROB_SIZE", rob_sizes);
+        parse_size_list(argv[2], "IQ_SIZE", iq_sizes);
+        parse_size_list(argv[3], "WIDTH", widths);
+    }
+
     params.rob_size     = strtoul(argv[1], NULL, 10);
     params.iq_size      = strtoul(argv[2], NULL, 10);
     params.width        = strtoul(argv[3], NULL, 10);
-    trace_file          = argv[4];
+    // rob tags are 16 bit in the instruction record
+    unsigned long max_rob_size = params.rob_size;
+    for(int r = 0; r < (int) rob_sizes.size(); r++)
+        max_rob_size = max(max_rob_size, rob_sizes[r]);
+    if(max_rob_size > INSTR_MAX_ROB_SIZE)
+    {
+        printf("Error: ROB_SIZE can be at most %d\n", INSTR_MAX_ROB_SIZE);
+        exit(EXIT_FAILURE);
+    }
+    // the pipeline and the interval model never finish the trace otherwise
+    // (a sweep marks such points invalid, --dataflow only uses WIDTH)
+    if(!is_sweep && !opts.dataflow && !proc_params_valid(&params))
+    {
+        printf("Error: WIDTH has to be at least 1 and at most ROB_SIZE and IQ_SIZE\n");
+        exit(EXIT_FAILURE);
+    }
     // printf("rob_size:%lu "
     //         "iq_size:%lu "
     //         "width:%lu "
     //         "tracefile:%s\n", params.rob_size, params.iq_size, params.width, trace_file);
     // Open trace_file in read mode
-    FP = fopen(trace_file, "r");
-    if(FP == NULL)
+    // a fresh binary sidecar (made by trace2bin) is memory mapped instead of parsing the text
+    if(!trace.trace_open(trace_file, opts.binary_sidecar, opts.prefetch_trace))
     {
         // Throw error and exit if fopen() failed
         printf("Error: Unable to open file %s\n", trace_file);
         exit(EXIT_FAILURE);
     }
-    
-    //creating rmt table
-    rmt rmt_table;
-    rmt_table.rmt_initialize();
-
 
-    vector<instruction> instrs_in_pipe;
-	pipeline_data m_data;
-	rob rob;
-	rmt rmt;
-	issue_queue iq;
-	iq.issue_queue_initialize(params.iq_size, params.width);
-	rmt.rmt_initialize();
-	rob.rob_initialize(params.rob_size, params.width);
-	m_data.simulation_cycle = 0;
-	m_data.is_simulation_done = false;
-	m_data.sequence = 0;
-	m_data.trace_depleted_f = false;
-	m_data.rob_full = false;
-	m_data.issue_queue_full = false;
-	m_data.dispatch_busy = false;
-	m_data.reg_read_busy = false;
-	m_data.rename_busy = false;
-	m_data.decode_busy = false;
-	m_data.issue_queue_empty = true;
-
-	do{
-		retire(&m_data, &params, &rob, instrs_in_pipe, &rmt);
-
-		writeback(&m_data, instrs_in_pipe, &rob);
-
-		execute(&m_data, &params, instrs_in_pipe, &rob, &iq);
-		
-		issue(&m_data, &params, instrs_in_pipe, &iq, &rob);
-
-		dispatch(&m_data, &params, instrs_in_pipe, &iq);
+    if(is_sweep)
+    {
+        run_sweep(rob_sizes, iq_sizes, widths, &trace, trace_file, &opts);
+        trace.trace_close();
+        return 0;
+    }
 
-		regread(&m_data, &params, instrs_in_pipe, &rob);
+    if(opts.dataflow)
+    {
+        if(params.width == 0)
+        {
+            printf("Error: Invalid WIDTH %s\n", argv[3]);
+            exit(EXIT_FAILURE);
+        }
+        dataflow_result result;
+        run_dataflow_analysis(&trace, params.width, &result);
+        trace.trace_close();
+        print_configuration(&params, trace_file);
+        print_dataflow_result(&result);
+        return 0;
+    }
 
-		rename(&m_data, &params, instrs_in_pipe, &rmt, &rob);
-		
-		decode(&m_data, &params, instrs_in_pipe);
+    if(opts.simpoint)
+    {
+        simpoint_result result;
+        run_simpoint(&params, &opts, &trace, trace_file, &result);
+        trace.trace_close();
+        print_configuration(&params, trace_file);
+        print_simpoint_result(&result);
+        printf("# === Simulation Results ========\n");
+        printf("# Dynamic Instruction Count    = %" PRIu64 "\n", result.instructions);
+        printf("# Cycles                       = %" PRIu64 "\n", result.cycles);
+        printf("# Instructions Per Cycle (IPC) = %.2lf\n", (double) result.instructions / (double) result.cycles);
+        return 0;
+    }
 
-		fetch(&m_data, &params, instrs_in_pipe, FP);
+    if(opts.smarts)
+    {
+        smarts_result result;
+        run_smarts(&params, &opts, &trace, trace_file, &result);
+        trace.trace_close();
+        print_configuration(&params, trace_file);
+        print_smarts_result(&result, &opts);
+        printf("# === Simulation Results ========\n");
+        printf("# Dynamic Instruction Count    = %" PRIu64 "\n", result.instructions);
+        printf("# Cycles                       = %" PRIu64 "\n", result.cycles);
+        printf("# Instructions Per Cycle (IPC) = %.2lf\n", (double) result.instructions / (double) result.cycles);
+        return 0;
+    }
 
-	}while(!Advance_Cycle(&m_data));
+    model_result model;
+    if(opts.model)
+    {
+        run_interval_model(&trace, &params, &model);
+        trace.trace_close();
+        print_configuration(&params, trace_file);
+        printf("# === Simulation Results ========\n");
+        printf("# Dynamic Instruction Count    = %" PRIu64 "\n", model.instructions);
+        printf("# Cycles                       = %" PRIu64 "\n", model.cycles);
+        printf("# Instructions Per Cycle (IPC) = %.2lf\n", (double) model.instructions / (double) model.cycles);
+        return 0;
+    }
+    //the model needs its own pass over the trace, keep the records around
+    vector<trace_record> model_recs;
+    trace_reader model_trace;
+    if(opts.model_check)
+    {
+        uint64_t num_recs;
+        const trace_record *recs = trace.get_records(&num_recs);
+        if(recs == NULL)
+        {
+            num_recs = load_trace(&trace, model_recs);
+            recs = model_recs.empty() ? NULL : &model_recs[0];
+            trace.trace_close();
+            trace.trace_open_records(recs, num_recs);
+        }
+        model_trace.trace_open_records(recs, num_recs);
+        run_interval_model(&model_trace, &params, &model);
+    }
+    
+	pipeline_data m_data;
+	run_simulation(&params, &opts, &trace, &m_data, !opts.quiet);
+	trace.trace_close();
 
 	//int num_instr_in_pipe = instrs_in_pipe.size();
 	//
@@ -108,16 +416,20 @@ int main (int argc, char* argv[])
 	//cout << "Simulation cycles: " << m_data.simulation_cycle << endl;
     //while(fscanf(FP, "%lx %d %d %d %d", &pc, &op_type, &dest, &src1, &src2) != EOF)
     //    printf("%lx %d %d %d %d\n", pc, op_type, dest, src1, src2); //Print to check if inputs have been read correctly
-	printf("# === Simulator Command =========\n");
-	printf("# ./sim %lu %lu %lu %s\n", params.rob_size, params.iq_size, params.width, trace_file);
-	printf("# === Processor Configuration ===\n");
-	printf("# ROB_SIZE = %lu\n", params.rob_size);
-	printf("# IQ_SIZE  = %lu\n", params.iq_size);
-	printf("# WIDTH    = %lu\n", params.width);
+	print_configuration(&params, trace_file);
 	printf("# === Simulation Results ========\n");
-	printf("# Dynamic Instruction Count    = %u\n", m_data.sequence);
-	printf("# Cycles                       = %u\n", m_data.simulation_cycle);
+	printf("# Dynamic Instruction Count    = %" PRIu64 "\n", m_data.sequence);
+	printf("# Cycles                       = %" PRIu64 "\n", m_data.simulation_cycle);
 	double IPC = (double) m_data.sequence / (double) m_data.simulation_cycle;
 	printf("# Instructions Per Cycle (IPC) = %.2lf\n", IPC);
+	if(opts.stats)
+		print_pipeline_stats(stdout, &m_data.stats, m_data.simulation_cycle);
+	if(opts.model_check)
+		print_model_error(&model, m_data.simulation_cycle);
+#ifdef SIM_PROFILE
+	//on stderr, so the output itself stays the same as without profiling
+	fflush(stdout);
+	print_stage_profile(stderr, &m_data.profile, m_data.simulation_cycle);
+#endif
     return 0;
 }
@@ -2,6 +2,9 @@
 #define SIM_PROC_H
 
 #include <vector>
+#include <stdint.h>
+
+class timing_writer;
 
 typedef struct proc_params{
     unsigned long int rob_size;
@@ -9,6 +12,71 @@ typedef struct proc_params{
     unsigned long int width;
 }proc_params;
 
+//optional simulator settings given after the trace file on the command line
+//they change how the simulator runs, never the simulated results
+typedef struct sim_options{
+	//skip over cycles in which the whole pipeline is stalled (on by default)
+	//--no-cycle-skip evaluates every stage in every cycle
+	bool cycle_skip;
+	//run the pipeline compiled for the configuration when there is one (on by
+	//default). --no-specialize always runs the generic pipeline
+	bool specialize;
+	//use <trace>.bin instead of the text trace when it is up to date (on by default)
+	//--no-binary-trace always parses the text trace
+	bool binary_sidecar;
+	//parse a text trace on a separate thread ahead of fetch (off by default)
+	//--prefetch-trace turns it on
+	bool prefetch_trace;
+	//format the per-instruction log on a separate writer thread (--async-output)
+	bool async_output;
+	//no per-instruction log, only the summary (--quiet)
+	bool quiet;
+	//only log the instructions with sequence numbers in [first, last]
+	//(--print-range first:last), everything by default
+	uint64_t print_range_first;
+	uint64_t print_range_last;
+	//also write a binary timing log to this file (--timing-log <file>), NULL = none
+	const char *timing_log_file;
+	//count stall causes and ROB/IQ occupancy and print them after the summary (--stats)
+	bool stats;
+	//write IPC, occupancy and stalls of every interval to this CSV file
+	//(--interval-log FILE), NULL = none
+	const char *interval_log_file;
+	//length of an interval in cycles (--interval N, default 10000) or,
+	//when not 0, in retired instructions (--interval-instrs N)
+	uint64_t interval_cycles;
+	uint64_t interval_instrs;
+	//only run the dataflow limit analysis instead of the pipeline (--dataflow)
+	bool dataflow;
+	//estimate the cycles with the interval model instead of the pipeline (--model)
+	bool model;
+	//simulate the pipeline and also report the error of the interval model (--model-check)
+	bool model_check;
+	//only simulate SimPoint simulation points and weight their CPI (--simpoint)
+	bool simpoint;
+	//instructions per interval (--simpoint-interval N, default 100000)
+	uint64_t simpoint_interval;
+	//most clusters tried by k-means (--simpoint-k K, default 10)
+	unsigned int simpoint_max_k;
+	//SMARTS sampling until the IPC is within a target error (--smarts)
+	bool smarts;
+	//instructions per sampling unit (--smarts-unit N, default 1000)
+	uint64_t smarts_unit;
+	//target half width of the confidence interval in percent of the CPI
+	//(--smarts-error E, default 1) and its confidence level in percent
+	//(--smarts-confidence C, default 99.7)
+	double smarts_error;
+	double smarts_confidence;
+	//instructions simulated in detail before a sampled region (--warmup N,
+	//default 10000, with --smarts 2 * smarts_unit)
+	uint64_t warmup;
+	//print CSV rows even for a single configuration (--sweep)
+	//a sweep also runs whenever ROB_SIZE, IQ_SIZE or WIDTH is a list
+	bool sweep;
+	//threads used by a sweep, 0 = one per hardware thread (--threads N)
+	unsigned int sweep_threads;
+}sim_options;
+
 // Put additional data structures here as per your requirement
 enum {
 	FETCH = 1,
@@ -22,17 +90,114 @@ enum {
 	RETIRE = 9
 };
 
+//reasons for a stage to hold its instructions in a cycle (--stats)
+//a stage only counts as stalled when it has instructions to move
+enum {
+	//fetch: decode still holds its bundle
+	STALL_FETCH_DECODE_BUSY,
+	//decode: rename still holds its bundle
+	STALL_DECODE_RENAME_BUSY,
+	//rename: the ROB does not have width free entries
+	STALL_RENAME_ROB_FULL,
+	//rename: register read still holds its bundle
+	STALL_RENAME_REGREAD_BUSY,
+	//register read: dispatch still holds its bundle
+	STALL_REGREAD_DISPATCH_BUSY,
+	//dispatch: the IQ does not have width free entries
+	STALL_DISPATCH_IQ_FULL,
+	//issue: the IQ has entries, but none of them is ready
+	STALL_ISSUE_NONE_READY,
+	//retire: the ROB has entries, but the head has not finished
+	STALL_RETIRE_HEAD_NOT_READY,
+	NUM_STALL_CAUSES
+};
+
+//stall and occupancy statistics of a run (--stats)
+typedef struct pipeline_stats{
+	//causes that held a stage in the current cycle, one bit per cause
+	uint32_t stalls_this_cycle;
+	//cycles in which each cause held its stage
+	uint64_t stall_cycles[NUM_STALL_CAUSES];
+	//cycles with n valid ROB / IQ entries at the end of the cycle, indexed by n
+	std::vector<uint64_t> rob_occupancy;
+	std::vector<uint64_t> iq_occupancy;
+	//sum over all cycles of the valid ROB / IQ entries (mean occupancy)
+	uint64_t rob_occupancy_sum;
+	uint64_t iq_occupancy_sum;
+}pipeline_stats;
+
+//counters at the start of the current interval of the interval log
+//(--interval-log), the next row is the difference to the counters then
+typedef struct interval_snapshot{
+	uint64_t cycle;
+	uint64_t retired;
+	uint64_t rob_occupancy_sum;
+	uint64_t iq_occupancy_sum;
+	uint64_t stall_cycles[NUM_STALL_CAUSES];
+}interval_snapshot;
+
+#ifdef SIM_PROFILE
+//host time per stage (stage_profile.cc), only in builds with make PROFILE=1
+enum {
+	PROF_FETCH,
+	PROF_DECODE,
+	PROF_RENAME,
+	PROF_REG_READ,
+	PROF_DISPATCH,
+	PROF_ISSUE,
+	PROF_EXECUTE,
+	PROF_WRITE_BACK,
+	PROF_RETIRE,
+	//formatting the per-instruction logs (part of retire)
+	PROF_OUTPUT,
+	PROF_CYCLE_SKIP,
+	PROF_NUM_SLOTS
+};
+
+typedef struct stage_profile{
+	//host ticks spent in every slot
+	uint64_t ticks[PROF_NUM_SLOTS];
+	//ticks and nanoseconds at the start and the end of the run
+	//give the tick rate
+	uint64_t start_ticks;
+	uint64_t end_ticks;
+	uint64_t start_ns;
+	uint64_t end_ns;
+}stage_profile;
+#endif
+
 //keep track of various parameters in the simulation
 typedef struct pipeline_data{
 
 	//tracks cycles for the entire simulation
-	unsigned int simulation_cycle; 
+	uint64_t simulation_cycle;
 
     //to know whether simulation is completed
 	bool is_simulation_done;
 
+	//set by any stage that moves an instruction in the current cycle
+	//a cycle without progress can only be followed by more of the same
+	//until an instruction finishes execution
+	bool progress_this_cycle;
+
+	//the timing of every instruction is written here when it retires
+	//NULL when the per-instruction log is not wanted
+	timing_writer *instr_log;
+	//binary timing log (timing_log.h), NULL when not wanted
+	timing_writer *instr_bin_log;
+	//sequence numbers of the first and last instruction to log
+	uint64_t log_first;
+	uint64_t log_last;
+
 	//keep track of the age of an instruction
-	unsigned int sequence;
+	uint64_t sequence;
+
+	//number of instructions retired so far
+	uint64_t num_retired;
+
+	//number of instructions fetched but not yet retired
+	//simulation is done when this drops to 0 after a retire
+	unsigned int num_instrs_in_pipeline;
 
 	//varaiables reflecting readiness of various stages
     //when head = tail -> rob is full
@@ -55,13 +220,21 @@ typedef struct pipeline_data{
 
 	//multiple instruction may be finishing execution in the same cycle
 	//so we need to wakeup all the dependent instructions in each stage
-	std::vector<int> rob_destinations_ready_this_cycle;
+	//one bit per rob tag (bit i of word i/64), set by execute when the
+	//instruction finishes and cleared by writeback in the next cycle
+	std::vector<uint64_t> rob_tags_ready_this_cycle;
 
 	//signals signifying end of simulation
 	bool trace_depleted_f;
 	bool rob_head_equal_tail;
 	bool issue_queue_empty;
 
+	pipeline_stats stats;
+
+#ifdef SIM_PROFILE
+	stage_profile profile;
+#endif
+
 }pipeline_data;
 
 #endif
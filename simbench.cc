@@ -0,0 +1,351 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <inttypes.h>
+
+#include <vector>
+#include <string>
+#include <chrono>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+using namespace std;
+
+/*  measures how fast sim itself runs (make bench)
+
+    runs sim on every trace for every configuration of the matrix and reports
+    simulated instructions and cycles per host second and the peak RSS of the
+    sim process. every run is repeated and the fastest one is kept.
+    the results are written as JSON, which a later run can compare against
+
+    Example:-
+    simbench --json bench.json
+        runs the default matrix and writes bench.json
+    simbench --compare bench.json --json bench_new.json
+        same, and reports every entry that got more than 10% slower
+        (exits with an error if there is one)
+
+    Options:-
+    --sim PATH          sim binary to measure (default ./sim)
+    --json FILE         write the results to FILE
+    --compare FILE      compare against the results of an earlier run
+    --tolerance PCT     slowdown that counts as a regression (default 10)
+    --repeat N          runs per entry, the fastest one is kept (default 3)
+    --log               also format the per-instruction log (to /dev/null)
+                        instead of running sim with --quiet
+    --synth-instrs N    length of the synthetic traces (default 1000000)
+*/
+
+//configurations of the matrix
+typedef struct bench_config{
+	unsigned long rob_size;
+	unsigned long iq_size;
+	unsigned long width;
+}bench_config;
+
+static const bench_config bench_configs[] = {
+	{16, 8, 1},
+	{64, 16, 2},
+	{128, 32, 4},
+	{512, 128, 8},
+};
+
+//traces of the matrix. the synthetic ones are generated in bench_traces/
+static const char *bench_traces[] = {
+	"proj3-traces/val_trace_gcc1",
+	"proj3-traces/val_trace_perl1",
+	"bench_traces/synth_mix",
+	"bench_traces/synth_chain",
+};
+
+//results of one (trace, configuration) entry
+typedef struct bench_result{
+	string trace;
+	bench_config config;
+	uint64_t instructions;
+	uint64_t cycles;
+	double seconds;
+	long peak_rss_kb;
+}bench_result;
+
+//small deterministic generator, so the synthetic traces never change
+static uint64_t synth_state = 0x9e3779b97f4a7c15ull;
+static uint32_t synth_rand()
+{
+	synth_state = synth_state * 6364136223846793005ull + 1442695040888963407ull;
+	return synth_state >> 33;
+}
+
+//writes a synthetic trace unless it already exists
+//synth_mix:   a mix of all the op types with short and long dependences
+//synth_chain: long latency ops that mostly depend on the previous one,
+//             so the pipeline spends most of its cycles waiting on execute
+static bool make_synthetic_trace(const char *file, bool chain, uint64_t num_instrs)
+{
+	struct stat st;
+	if(stat(file, &st) == 0)
+		return true;
+	mkdir("bench_traces", 0755);
+	FILE *fp = fopen(file, "w");
+	if(fp == NULL)
+		return false;
+	synth_state = chain ? 0x2545f4914f6cdd1dull : 0x9e3779b97f4a7c15ull;
+	unsigned long pc = 0x400000;
+	int last_dst = 1;
+	for(uint64_t i = 0; i < num_instrs; i++)
+	{
+		int op_type, dst, src1, src2;
+		if(chain)
+		{
+			op_type = (synth_rand() % 8 == 0) ? 0 : 2;
+			src1 = (synth_rand() % 16 == 0) ? (int) (synth_rand() % 67) : last_dst;
+			src2 = -1;
+			dst = synth_rand() % 67;
+		}
+		else
+		{
+			uint32_t r = synth_rand() % 100;
+			op_type = (r < 60) ? 0 : (r < 85) ? 1 : 2;
+			dst = (synth_rand() % 10 == 0) ? -1 : (int) (synth_rand() % 67);
+			src1 = (synth_rand() % 4 == 0) ? last_dst : (int) (synth_rand() % 67);
+			src2 = (synth_rand() % 3 == 0) ? -1 : (int) (synth_rand() % 67);
+		}
+		if(dst != -1)
+			last_dst = dst;
+		fprintf(fp, "%lx %d %d %d %d\n", pc, op_type, dst, src1, src2);
+		pc += 4;
+	}
+	fclose(fp);
+	return true;
+}
+
+//runs sim once, fills in the instructions, cycles, time and peak RSS
+static bool run_sim(const char *sim, const char *trace, bench_config *config, bool log, bench_result *result)
+{
+	char rob_size[32], iq_size[32], width[32];
+	snprintf(rob_size, sizeof(rob_size), "%lu", config->rob_size);
+	snprintf(iq_size, sizeof(iq_size), "%lu", config->iq_size);
+	snprintf(width, sizeof(width), "%lu", config->width);
+
+	int out[2];
+	if(pipe(out) != 0)
+		return false;
+
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	pid_t pid = fork();
+	if(pid < 0)
+		return false;
+	if(pid == 0)
+	{
+		dup2(out[1], STDOUT_FILENO);
+		close(out[0]);
+		close(out[1]);
+		if(log)
+			execl(sim, sim, rob_size, iq_size, width, trace, (char *) NULL);
+		else
+			execl(sim, sim, rob_size, iq_size, width, trace, "--quiet", (char *) NULL);
+		_exit(127);
+	}
+	close(out[1]);
+
+	//only the summary lines (starting with '#') are kept
+	FILE *fp = fdopen(out[0], "r");
+	char line[4096];
+	bool at_line_start = true;
+	result->instructions = 0;
+	result->cycles = 0;
+	while(fgets(line, sizeof(line), fp) != NULL)
+	{
+		if(at_line_start && line[0] == '#')
+		{
+			sscanf(line, "# Dynamic Instruction Count    = %" SCNu64, &result->instructions);
+			sscanf(line, "# Cycles                       = %" SCNu64, &result->cycles);
+		}
+		at_line_start = strchr(line, '\n') != NULL;
+	}
+	fclose(fp);
+
+	int status;
+	struct rusage usage;
+	if(wait4(pid, &status, 0, &usage) != pid)
+		return false;
+	chrono::steady_clock::time_point end = chrono::steady_clock::now();
+	if(!WIFEXITED(status) || WEXITSTATUS(status) != 0 || result->cycles == 0)
+		return false;
+
+	result->seconds = chrono::duration<double>(end - start).count();
+	//ru_maxrss is in kilobytes on linux
+	result->peak_rss_kb = usage.ru_maxrss;
+	return true;
+}
+
+static void write_json(const char *file, vector<bench_result>& results, bool log)
+{
+	FILE *fp = fopen(file, "w");
+	if(fp == NULL)
+	{
+		printf("Error: Unable to create file %s\n", file);
+		exit(EXIT_FAILURE);
+	}
+	//one entry per line, so an earlier file can be read back with sscanf
+	fprintf(fp, "{\n\"log\": %s,\n\"results\": [\n", log ? "true" : "false");
+	for(int i = 0; i < (int) results.size(); i++)
+	{
+		bench_result& r = results[i];
+		fprintf(fp, "{\"trace\": \"%s\", \"rob_size\": %lu, \"iq_size\": %lu, \"width\": %lu, "
+			"\"instructions\": %" PRIu64 ", \"cycles\": %" PRIu64 ", \"seconds\": %.6f, "
+			"\"kips\": %.1f, \"mcycles_per_sec\": %.3f, \"peak_rss_kb\": %ld}%s\n",
+			r.trace.c_str(), r.config.rob_size, r.config.iq_size, r.config.width,
+			r.instructions, r.cycles, r.seconds,
+			r.instructions / r.seconds / 1e3, r.cycles / r.seconds / 1e6, r.peak_rss_kb,
+			(i + 1 < (int) results.size()) ? "," : "");
+	}
+	fprintf(fp, "]\n}\n");
+	fclose(fp);
+}
+
+//reads the entries of an earlier JSON file written by write_json
+static bool read_json(const char *file, vector<bench_result>& results)
+{
+	FILE *fp = fopen(file, "r");
+	if(fp == NULL)
+		return false;
+	char line[4096];
+	while(fgets(line, sizeof(line), fp) != NULL)
+	{
+		char trace[1024];
+		bench_result r;
+		if(sscanf(line, "{\"trace\": \"%1023[^\"]\", \"rob_size\": %lu, \"iq_size\": %lu, \"width\": %lu, "
+			"\"instructions\": %" SCNu64 ", \"cycles\": %" SCNu64 ", \"seconds\": %lf, "
+			"\"kips\": %*f, \"mcycles_per_sec\": %*f, \"peak_rss_kb\": %ld}",
+			trace, &r.config.rob_size, &r.config.iq_size, &r.config.width,
+			&r.instructions, &r.cycles, &r.seconds, &r.peak_rss_kb) == 8)
+		{
+			r.trace = trace;
+			results.push_back(r);
+		}
+	}
+	fclose(fp);
+	return true;
+}
+
+int main(int argc, char* argv[])
+{
+	const char *sim = "./sim";
+	const char *json_file = NULL;
+	const char *compare_file = NULL;
+	double tolerance = 10.0;
+	int repeat = 3;
+	bool log = false;
+	uint64_t synth_instrs = 1000000;
+
+	for(int i = 1; i < argc; i++)
+	{
+		if(strcmp(argv[i], "--sim") == 0 && i + 1 < argc)
+			sim = argv[++i];
+		else if(strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+			json_file = argv[++i];
+		else if(strcmp(argv[i], "--compare") == 0 && i + 1 < argc)
+			compare_file = argv[++i];
+		else if(strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc)
+			tolerance = atof(argv[++i]);
+		else if(strcmp(argv[i], "--repeat") == 0 && i + 1 < argc)
+			repeat = atoi(argv[++i]);
+		else if(strcmp(argv[i], "--log") == 0)
+			log = true;
+		else if(strcmp(argv[i], "--synth-instrs") == 0 && i + 1 < argc)
+			synth_instrs = strtoull(argv[++i], NULL, 10);
+		else
+		{
+			printf("Error: Unknown option %s\n", argv[i]);
+			exit(EXIT_FAILURE);
+		}
+	}
+	if(repeat < 1)
+		repeat = 1;
+
+	if(!make_synthetic_trace("bench_traces/synth_mix", false, synth_instrs) ||
+	   !make_synthetic_trace("bench_traces/synth_chain", true, synth_instrs))
+	{
+		printf("Error: Unable to create the synthetic traces in bench_traces/\n");
+		exit(EXIT_FAILURE);
+	}
+
+	vector<bench_result> baseline;
+	if(compare_file != NULL && !read_json(compare_file, baseline))
+	{
+		printf("Error: Unable to open file %s\n", compare_file);
+		exit(EXIT_FAILURE);
+	}
+
+	printf("%-28s %4s %4s %2s %10s %10s %8s %10s %8s %9s\n", "trace", "rob", "iq", "w",
+		"instrs", "cycles", "seconds", "KIPS", "Mcyc/s", "RSS(KB)");
+
+	vector<bench_result> results;
+	int regressions = 0;
+	int num_traces = sizeof(bench_traces) / sizeof(bench_traces[0]);
+	int num_configs = sizeof(bench_configs) / sizeof(bench_configs[0]);
+	for(int t = 0; t < num_traces; t++)
+		for(int c = 0; c < num_configs; c++)
+		{
+			bench_config config = bench_configs[c];
+			bench_result best;
+			for(int k = 0; k < repeat; k++)
+			{
+				bench_result r;
+				if(!run_sim(sim, bench_traces[t], &config, log, &r))
+				{
+					printf("Error: %s %lu %lu %lu %s failed\n", sim, config.rob_size, config.iq_size, config.width, bench_traces[t]);
+					exit(EXIT_FAILURE);
+				}
+				if(k == 0 || r.seconds < best.seconds)
+					best = r;
+			}
+			best.trace = bench_traces[t];
+			best.config = config;
+			results.push_back(best);
+
+			double kips = best.instructions / best.seconds / 1e3;
+			printf("%-28s %4lu %4lu %2lu %10" PRIu64 " %10" PRIu64 " %8.3f %10.1f %8.3f %9ld",
+				bench_traces[t], config.rob_size, config.iq_size, config.width,
+				best.instructions, best.cycles, best.seconds, kips,
+				best.cycles / best.seconds / 1e6, best.peak_rss_kb);
+
+			//compare the instructions per host second with the same entry of the baseline
+			for(int b = 0; b < (int) baseline.size(); b++)
+			{
+				bench_result& old = baseline[b];
+				if(old.trace != best.trace || old.config.rob_size != config.rob_size ||
+				   old.config.iq_size != config.iq_size || old.config.width != config.width)
+					continue;
+				double old_kips = old.instructions / old.seconds / 1e3;
+				double change = (kips - old_kips) / old_kips * 100.0;
+				printf("  %+6.1f%%", change);
+				if(change < -tolerance)
+				{
+					printf(" REGRESSION");
+					regressions++;
+				}
+				if(old.cycles != best.cycles)
+					printf(" (cycles changed: %" PRIu64 ")", old.cycles);
+				break;
+			}
+			printf("\n");
+			fflush(stdout);
+		}
+
+	if(json_file != NULL)
+		write_json(json_file, results, log);
+
+	if(regressions > 0)
+	{
+		printf("%d entries are more than %.1f%% slower than %s\n", regressions, tolerance, compare_file);
+		return 1;
+	}
+	return 0;
+}
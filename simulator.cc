@@ -0,0 +1,391 @@
+//runs a trace through the pipeline
+//all the state of one simulation lives in a simulator object, so any number of
+//simulations can run side by side in one process (see sweep.cc and libsim.cc)
+#include <stdio.h>
+#include <stdlib.h>
+#include "sim_proc.h"
+
+#include "pipeline_stages.cc"
+
+
+bool Advance_Cycle(pipeline_data *meta)
+{
+	meta->simulation_cycle++;
+	//every cycle starts without any progress
+	meta->progress_this_cycle = false;
+	return meta->is_simulation_done;
+}
+
+//the ROB and the IQ have to take a whole fetch group, the pipeline never
+//retires the trace otherwise. the interval model makes the same assumption
+bool proc_params_valid(proc_params *params)
+{
+	return !(params->width == 0 || params->rob_size < params->width || params->iq_size < params->width);
+}
+
+//one out of order core simulating one trace
+//the trace reader is owned by the caller and must stay open while simulating
+class simulator
+{
+	private:
+		proc_params params;
+		sim_options opts;
+		trace_reader *trace;
+
+		pipeline_data m_data;
+		pipeline_latches latches;
+		rob rob_buffer;
+		rmt rename_table;
+		issue_queue iq;
+
+        //per-instruction log, only used with print_instrs
+		timing_writer instr_log;
+        //binary timing log, only used with opts.timing_log_file
+		timing_writer instr_bin_log;
+		FILE *bin_log_file;
+
+        //interval log, only used with opts.interval_log_file
+		FILE *interval_file;
+        //counters at the start of the current interval
+		interval_snapshot interval_start;
+        //cycle (or retired instruction count) that ends the current interval
+		uint64_t interval_end;
+
+        //output file that could not be created by simulator_initialize
+		const char *failed_file;
+
+#ifdef SIM_ALLOC_CHECK
+        //heap allocations of this thread when the setup was done
+		uint64_t allocs_at_setup;
+#endif
+
+        //writes a row of the interval log when the current interval is over
+		void check_interval();
+
+        //simulates one cycle, plus at most max_skip quiescent cycles after it
+        //compiled for a configuration (WIDTH, ROB_SIZE, IQ_SIZE) or, with all
+        //three 0, for the sizes in params
+		template<unsigned int WIDTH, unsigned int ROB_SIZE, unsigned int IQ_SIZE>
+		void run_cycle(uint64_t max_skip);
+
+		typedef void (simulator::*cycle_function)(uint64_t max_skip);
+        //run_cycle for this configuration, picked by select_run_cycle
+		cycle_function run_cycle_fn;
+
+        //picks the run_cycle compiled for the configuration, or the generic one
+        //when there is none (see SPECIALIZED_* below)
+		static cycle_function select_run_cycle(proc_params *params);
+		template<unsigned int WIDTH>
+		static cycle_function select_rob_size(proc_params *params);
+		template<unsigned int WIDTH, unsigned int ROB_SIZE>
+		static cycle_function select_iq_size(proc_params *params);
+
+	public:
+        //sets up an empty pipeline for the configuration
+        //with print_instrs, the timing of every instruction is printed to stdout
+        //when it retires (the log is complete once the simulation is done)
+        //returns false if an output file (timing or interval log) cannot be created
+		bool simulator_initialize(proc_params *params, sim_options *opts, trace_reader *trace, bool print_instrs);
+
+        //simulates exactly one cycle, even with cycle skipping on
+        //returns true once the simulation is done
+		bool step();
+
+        //simulates n more cycles, or less if the simulation finishes first
+        //returns the number of cycles simulated
+		uint64_t run_n_cycles(uint64_t n);
+
+        //simulates until the last instruction retires
+		void run_to_end();
+
+        //writes out the rest of the per-instruction log and stops its writer
+		void simulator_close();
+
+		bool is_done(){
+            return m_data.is_simulation_done;
+        }
+
+        //stats: instructions retired and cycles so far (sequence counts the
+        //fetched instructions, which is only the same once the run is done)
+		uint64_t get_instruction_count(){
+            return m_data.num_retired;
+        }
+		uint64_t get_cycles(){
+            return m_data.simulation_cycle;
+        }
+
+		pipeline_data *get_pipeline_data(){
+            return &m_data;
+        }
+
+		const char *get_failed_file(){
+            return failed_file;
+        }
+};
+
+bool simulator::simulator_initialize(proc_params *params, sim_options *opts, trace_reader *trace, bool print_instrs)
+{
+	this->params = *params;
+	this->opts = *opts;
+	this->trace = trace;
+	//open the output files first, so little has to be undone if that fails
+	bin_log_file = NULL;
+	interval_file = NULL;
+	failed_file = NULL;
+	if(opts->timing_log_file != NULL)
+	{
+		bin_log_file = fopen(opts->timing_log_file, "wb");
+		if(bin_log_file == NULL)
+		{
+			failed_file = opts->timing_log_file;
+			return false;
+		}
+	}
+	if(opts->interval_log_file != NULL)
+	{
+		interval_file = fopen(opts->interval_log_file, "w");
+		if(interval_file == NULL)
+		{
+			failed_file = opts->interval_log_file;
+			if(bin_log_file != NULL)
+				fclose(bin_log_file);
+			bin_log_file = NULL;
+			return false;
+		}
+	}
+	iq.issue_queue_initialize(params->iq_size, params->width, params->rob_size);
+	rename_table.rmt_initialize();
+	rob_buffer.rob_initialize(params->rob_size, params->width);
+	pipeline_latches_initialize(&latches, params);
+	run_cycle_fn = opts->specialize ? select_run_cycle(params) : &simulator::run_cycle<0, 0, 0>;
+	m_data.simulation_cycle = 0;
+	m_data.is_simulation_done = false;
+	m_data.progress_this_cycle = false;
+	m_data.sequence = 0;
+	m_data.num_instrs_in_pipeline = 0;
+	m_data.trace_depleted_f = false;
+	m_data.rob_full = false;
+	m_data.issue_queue_full = false;
+	m_data.dispatch_busy = false;
+	m_data.reg_read_busy = false;
+	m_data.rename_busy = false;
+	m_data.decode_busy = false;
+	m_data.issue_queue_empty = true;
+	m_data.num_retired = 0;
+	m_data.rob_tags_ready_this_cycle.assign((params->rob_size + 63) / 64, 0);
+	m_data.instr_log = NULL;
+	m_data.instr_bin_log = NULL;
+	m_data.log_first = opts->print_range_first;
+	m_data.log_last = opts->print_range_last;
+	pipeline_stats_initialize(&m_data.stats, params);
+#ifdef SIM_PROFILE
+	stage_profile_start(&m_data.profile);
+#endif
+	if(print_instrs)
+	{
+		instr_log.writer_initialize(stdout, opts->async_output);
+		m_data.instr_log = &instr_log;
+	}
+	if(bin_log_file != NULL)
+	{
+		instr_bin_log.writer_initialize(bin_log_file, opts->async_output);
+		instr_bin_log.begin_line();
+		instr_bin_log.put_bytes(TIMING_LOG_MAGIC, 8);
+		m_data.instr_bin_log = &instr_bin_log;
+	}
+	if(interval_file != NULL)
+	{
+		write_interval_header(interval_file);
+		take_interval_snapshot(&interval_start, &m_data);
+		interval_end = (opts->interval_instrs != 0) ? opts->interval_instrs : opts->interval_cycles;
+	}
+#ifdef SIM_ALLOC_CHECK
+	//everything the pipeline needs is allocated by now
+	allocs_at_setup = get_heap_allocations();
+#endif
+	return true;
+}
+
+void simulator::check_interval()
+{
+	if(opts.interval_instrs != 0)
+	{
+		if(m_data.num_retired < interval_end)
+			return;
+		write_interval_row(interval_file, &interval_start, &m_data);
+		interval_end = (m_data.num_retired / opts.interval_instrs + 1) * opts.interval_instrs;
+	}
+	else
+	{
+		//skips never cross the end of an interval, so it is hit exactly
+		if(m_data.simulation_cycle < interval_end)
+			return;
+		write_interval_row(interval_file, &interval_start, &m_data);
+		interval_end += opts.interval_cycles;
+	}
+}
+
+//the pipeline is compiled for every combination of these sizes
+//each one adds a copy of the pipeline to the binary, so only the widths and
+//sizes that sweeps use all the time are here
+//  WIDTH    1 2 4 8
+//  ROB_SIZE 32 64 128 256 512
+//  IQ_SIZE  8 16 32 64
+simulator::cycle_function simulator::select_run_cycle(proc_params *params)
+{
+	switch(params->width)
+	{
+		case 1: return select_rob_size<1>(params);
+		case 2: return select_rob_size<2>(params);
+		case 4: return select_rob_size<4>(params);
+		case 8: return select_rob_size<8>(params);
+	}
+	return &simulator::run_cycle<0, 0, 0>;
+}
+
+template<unsigned int WIDTH>
+simulator::cycle_function simulator::select_rob_size(proc_params *params)
+{
+	switch(params->rob_size)
+	{
+		case 32: return select_iq_size<WIDTH, 32>(params);
+		case 64: return select_iq_size<WIDTH, 64>(params);
+		case 128: return select_iq_size<WIDTH, 128>(params);
+		case 256: return select_iq_size<WIDTH, 256>(params);
+		case 512: return select_iq_size<WIDTH, 512>(params);
+	}
+	return &simulator::run_cycle<0, 0, 0>;
+}
+
+template<unsigned int WIDTH, unsigned int ROB_SIZE>
+simulator::cycle_function simulator::select_iq_size(proc_params *params)
+{
+	switch(params->iq_size)
+	{
+		case 8: return &simulator::run_cycle<WIDTH, ROB_SIZE, 8>;
+		case 16: return &simulator::run_cycle<WIDTH, ROB_SIZE, 16>;
+		case 32: return &simulator::run_cycle<WIDTH, ROB_SIZE, 32>;
+		case 64: return &simulator::run_cycle<WIDTH, ROB_SIZE, 64>;
+	}
+	return &simulator::run_cycle<0, 0, 0>;
+}
+
+template<unsigned int WIDTH, unsigned int ROB_SIZE, unsigned int IQ_SIZE>
+void simulator::run_cycle(uint64_t max_skip)
+{
+	//an interval of the interval log must not end inside a skip
+	if(interval_file != NULL && opts.interval_instrs == 0 && interval_end - m_data.simulation_cycle - 1 < max_skip)
+		max_skip = interval_end - m_data.simulation_cycle - 1;
+
+	//PROFILE_STAGE only times the stages in builds with make PROFILE=1
+	//(the calls with template arguments are in parentheses for the macro)
+	PROFILE_STAGE(&m_data, PROF_RETIRE, (retire<WIDTH, ROB_SIZE>(&m_data, &params, &rob_buffer, &latches, &rename_table)));
+
+	PROFILE_STAGE(&m_data, PROF_WRITE_BACK, writeback(&m_data, &latches, &rob_buffer));
+
+	PROFILE_STAGE(&m_data, PROF_EXECUTE, execute(&m_data, &params, &latches, &rob_buffer, &iq));
+
+	PROFILE_STAGE(&m_data, PROF_ISSUE, (issue<WIDTH, IQ_SIZE>(&m_data, &params, &latches, &iq, &rob_buffer)));
+
+	PROFILE_STAGE(&m_data, PROF_DISPATCH, (dispatch<WIDTH, IQ_SIZE>(&m_data, &params, &latches, &iq, &rob_buffer)));
+
+	PROFILE_STAGE(&m_data, PROF_REG_READ, regread(&m_data, &params, &latches, &rob_buffer));
+
+	PROFILE_STAGE(&m_data, PROF_RENAME, (rename<WIDTH, ROB_SIZE>(&m_data, &params, &latches, &rename_table, &rob_buffer)));
+
+	PROFILE_STAGE(&m_data, PROF_DECODE, decode(&m_data, &params, &latches));
+
+	PROFILE_STAGE(&m_data, PROF_FETCH, fetch<WIDTH>(&m_data, &params, &latches, trace));
+
+	//jump over the cycles in which the whole pipeline waits on execute
+	uint64_t skipped = 0;
+	if(opts.cycle_skip)
+		PROFILE_STAGE(&m_data, PROF_CYCLE_SKIP, skipped = skip_quiescent_cycles(&m_data, &latches, &rob_buffer, max_skip));
+
+	if(opts.stats || interval_file != NULL)
+		record_cycle_stats(&m_data.stats, &rob_buffer, &iq, 1 + skipped);
+
+	bool done = Advance_Cycle(&m_data);
+	if(interval_file != NULL)
+		check_interval();
+	if(done)
+	{
+#ifdef SIM_PROFILE
+		stage_profile_stop(&m_data.profile);
+#endif
+		if(m_data.instr_log != NULL)
+			m_data.instr_log->flush();
+		if(m_data.instr_bin_log != NULL)
+			m_data.instr_bin_log->flush();
+		//the last interval is usually shorter
+		if(interval_file != NULL)
+		{
+			write_interval_row(interval_file, &interval_start, &m_data);
+			fflush(interval_file);
+		}
+#ifdef SIM_ALLOC_CHECK
+		check_heap_allocations(allocs_at_setup, m_data.simulation_cycle);
+#endif
+	}
+}
+
+void simulator::simulator_close()
+{
+	if(m_data.instr_log != NULL)
+		m_data.instr_log->writer_close();
+	if(m_data.instr_bin_log != NULL)
+	{
+		m_data.instr_bin_log->writer_close();
+		fclose(bin_log_file);
+	}
+	m_data.instr_log = NULL;
+	m_data.instr_bin_log = NULL;
+	if(interval_file != NULL)
+		fclose(interval_file);
+	interval_file = NULL;
+}
+
+bool simulator::step()
+{
+	//no cycle skipping, a step is exactly one cycle
+	if(!m_data.is_simulation_done)
+		(this->*run_cycle_fn)(0);
+	return m_data.is_simulation_done;
+}
+
+uint64_t simulator::run_n_cycles(uint64_t n)
+{
+	uint64_t start = m_data.simulation_cycle;
+	uint64_t end = (n > UINT64_MAX - start) ? UINT64_MAX : start + n;
+	while(!m_data.is_simulation_done && m_data.simulation_cycle < end)
+	{
+		//the cycle itself takes one, so at most end - cycle - 1 can be skipped
+		(this->*run_cycle_fn)(end - m_data.simulation_cycle - 1);
+	}
+	return m_data.simulation_cycle - start;
+}
+
+void simulator::run_to_end()
+{
+	while(!m_data.is_simulation_done)
+		(this->*run_cycle_fn)(UINT64_MAX);
+}
+
+//simulates the whole trace for one processor configuration
+//results are left in m_data:
+//  m_data->sequence         -> dynamic instruction count
+//  m_data->simulation_cycle -> cycles
+//with print_instrs, the timing of every instruction is printed when it retires
+void run_simulation(proc_params *params, sim_options *opts, trace_reader *trace, pipeline_data *m_data, bool print_instrs)
+{
+	simulator *sim = new simulator;
+	if(!sim->simulator_initialize(params, opts, trace, print_instrs))
+	{
+		printf("Error: Unable to create file %s\n", sim->get_failed_file());
+		exit(EXIT_FAILURE);
+	}
+	sim->run_to_end();
+	sim->simulator_close();
+	*m_data = *sim->get_pipeline_data();
+	delete sim;
+}
@@ -0,0 +1,93 @@
+//host time spent in every pipeline stage (build with make PROFILE=1)
+//every stage call is timed with the time stamp counter (steady_clock where
+//there is none) and the ticks are added up per stage. at the end the ticks are
+//turned into seconds with the tick rate measured over the whole run.
+//without SIM_PROFILE all of this compiles away
+#include <stdio.h>
+#include <stdint.h>
+#include <inttypes.h>
+
+#include <chrono>
+
+#include "sim_proc.h"
+
+#ifdef SIM_PROFILE
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+static inline uint64_t profile_now()
+{
+	return __rdtsc();
+}
+#else
+static inline uint64_t profile_now()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+#endif
+
+static inline uint64_t profile_now_ns()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//times one call and adds it to the given slot of meta->profile
+#define PROFILE_STAGE(meta, slot, call) \
+	do{ \
+		uint64_t profile_start = profile_now(); \
+		call; \
+		(meta)->profile.ticks[slot] += profile_now() - profile_start; \
+	}while(0)
+
+void stage_profile_start(stage_profile *profile)
+{
+	for(int i = 0; i < PROF_NUM_SLOTS; i++)
+		profile->ticks[i] = 0;
+	profile->start_ticks = profile_now();
+	profile->start_ns = profile_now_ns();
+}
+
+void stage_profile_stop(stage_profile *profile)
+{
+	profile->end_ticks = profile_now();
+	profile->end_ns = profile_now_ns();
+}
+
+//prints the time of every stage, its share of the run and the time per
+//simulated cycle
+void print_stage_profile(FILE *out, stage_profile *profile, uint64_t cycles)
+{
+	static const char *slot_names[PROF_NUM_SLOTS] = {"fetch", "decode", "rename", "regread", "dispatch", "issue", "execute", "writeback", "retire", "output", "cycle skip"};
+	double total_ticks = (double) (profile->end_ticks - profile->start_ticks);
+	double total_ns = (double) (profile->end_ns - profile->start_ns);
+	double ns_per_tick = (total_ticks > 0) ? total_ns / total_ticks : 0.0;
+
+	//output formatting happens inside retire, so it is taken out of retire
+	double ticks[PROF_NUM_SLOTS];
+	for(int i = 0; i < PROF_NUM_SLOTS; i++)
+		ticks[i] = (double) profile->ticks[i];
+	ticks[PROF_RETIRE] -= ticks[PROF_OUTPUT];
+
+	fprintf(out, "# === Host Time Per Stage =======\n");
+	fprintf(out, "# %-12s %10s %7s %12s\n", "stage", "seconds", "share", "ns/cycle");
+	double staged = 0;
+	for(int i = 0; i < PROF_NUM_SLOTS; i++)
+	{
+		staged += ticks[i];
+		fprintf(out, "# %-12s %10.4f %6.1f%% %12.2f\n", slot_names[i], ticks[i] * ns_per_tick / 1e9,
+			(total_ticks > 0) ? 100.0 * ticks[i] / total_ticks : 0.0,
+			(cycles > 0) ? ticks[i] * ns_per_tick / cycles : 0.0);
+	}
+	//everything outside the stages: the cycle loop, trace reading at the end, ...
+	double rest = total_ticks - staged;
+	fprintf(out, "# %-12s %10.4f %6.1f%% %12.2f\n", "other", rest * ns_per_tick / 1e9,
+		(total_ticks > 0) ? 100.0 * rest / total_ticks : 0.0,
+		(cycles > 0) ? rest * ns_per_tick / cycles : 0.0);
+	fprintf(out, "# %-12s %10.4f\n", "total", total_ns / 1e9);
+}
+
+#else
+
+#define PROFILE_STAGE(meta, slot, call) call
+
+#endif
@@ -0,0 +1,236 @@
+//design space sweep
+//simulates a grid of (ROB_SIZE, IQ_SIZE, WIDTH) configurations for one trace
+//the trace is read once and shared by all the simulations in memory
+//configurations run on a pool of threads, each thread has its own queue of
+//configurations and steals from the back of the others' queues once its own
+//queue is empty, so a few slow (large) configurations do not hold up the rest
+//one CSV row is printed per configuration, in grid order
+//configurations the pipeline cannot run (WIDTH > ROB_SIZE or WIDTH > IQ_SIZE,
+//they would never retire the trace) are not simulated, their row says invalid
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+
+using namespace std;
+
+//one point of the grid and its results
+typedef struct sweep_point{
+	proc_params params;
+	uint64_t instructions;
+	uint64_t cycles;
+	bool valid;
+	bool done;
+}sweep_point;
+
+class sweep_pool
+{
+	private:
+        //the shared trace
+		const trace_record *recs;
+		uint64_t num_recs;
+		sim_options *opts;
+		const char *trace_name;
+
+		vector<sweep_point> *points;
+
+        //per thread queue of point indices
+		vector< deque<int> > queues;
+		vector<mutex> queue_locks;
+
+        //rows are printed in grid order as soon as all the earlier ones are done
+		mutex print_lock;
+		unsigned int next_to_print;
+
+        //gets the next point for a thread. own queue first (front), then
+        //steal from the other queues (back). returns false when all are taken
+		bool take_point(unsigned int worker, int *point);
+
+        //marks a point done and prints every finished row that is next in order
+		void finish_point(int point);
+        //prints every finished row that is next in order, print_lock held
+		void print_ready_rows();
+
+		void worker_loop(unsigned int worker);
+
+	public:
+		sweep_pool(const trace_record *recs, uint64_t num_recs, sim_options *opts, const char *trace_name, vector<sweep_point> *points, unsigned int num_threads);
+
+        //runs all the points and returns once every row is printed
+		void run();
+};
+
+sweep_pool::sweep_pool(const trace_record *recs, uint64_t num_recs, sim_options *opts, const char *trace_name, vector<sweep_point> *points, unsigned int num_threads)
+	: recs(recs), num_recs(num_recs), opts(opts), trace_name(trace_name), points(points), queues(num_threads), queue_locks(num_threads), next_to_print(0)
+{
+	//deal the valid points out round robin, the invalid ones are already done
+	unsigned int next_queue = 0;
+	for(int i = 0; i < (int) points->size(); i++)
+		if((*points)[i].valid)
+			queues[next_queue++ % num_threads].push_back(i);
+}
+
+bool sweep_pool::take_point(unsigned int worker, int *point)
+{
+	unsigned int num_workers = queues.size();
+	for(unsigned int k = 0; k < num_workers; k++)
+	{
+		unsigned int victim = (worker + k) % num_workers;
+		lock_guard<mutex> guard(queue_locks[victim]);
+		if(queues[victim].empty())
+			continue;
+		if(victim == worker)
+		{
+			*point = queues[victim].front();
+			queues[victim].pop_front();
+		}
+		else
+		{
+			*point = queues[victim].back();
+			queues[victim].pop_back();
+		}
+		return true;
+	}
+	return false;
+}
+
+void sweep_pool::finish_point(int point)
+{
+	lock_guard<mutex> guard(print_lock);
+	(*points)[point].done = true;
+	print_ready_rows();
+}
+
+void sweep_pool::print_ready_rows()
+{
+	while(next_to_print < points->size() && (*points)[next_to_print].done)
+	{
+		sweep_point& p = (*points)[next_to_print];
+		if(!p.valid)
+			printf("%lu,%lu,%lu,%s,,,invalid\n", p.params.rob_size, p.params.iq_size, p.params.width, trace_name);
+		else
+		{
+			double IPC = (double) p.instructions / (double) p.cycles;
+			printf("%lu,%lu,%lu,%s,%" PRIu64 ",%" PRIu64 ",%.2lf\n", p.params.rob_size, p.params.iq_size, p.params.width, trace_name, p.instructions, p.cycles, IPC);
+		}
+		next_to_print++;
+	}
+	fflush(stdout);
+}
+
+void sweep_pool::worker_loop(unsigned int worker)
+{
+	int point;
+	while(take_point(worker, &point))
+	{
+		sweep_point& p = (*points)[point];
+		//every simulation reads the shared records through its own reader
+		trace_reader trace;
+		trace.trace_open_records(recs, num_recs);
+		if(opts->model)
+		{
+			//estimate only, to prune the grid before simulating it in detail
+			model_result model;
+			run_interval_model(&trace, &p.params, &model);
+			p.instructions = model.instructions;
+			p.cycles = model.cycles;
+		}
+		else
+		{
+			pipeline_data m_data;
+			run_simulation(&p.params, opts, &trace, &m_data, false);
+			p.instructions = m_data.sequence;
+			p.cycles = m_data.simulation_cycle;
+		}
+		finish_point(point);
+	}
+}
+
+void sweep_pool::run()
+{
+	vector<thread> workers;
+	for(unsigned int w = 0; w < queues.size(); w++)
+		workers.push_back(thread(&sweep_pool::worker_loop, this, w));
+	for(unsigned int w = 0; w < workers.size(); w++)
+		workers[w].join();
+	//rows of invalid points that no finished point came after
+	lock_guard<mutex> guard(print_lock);
+	print_ready_rows();
+}
+
+//parses a comma separated list of sizes, e.g. "16,32,64"
+void parse_size_list(const char *arg, const char *name, vector<unsigned long>& values)
+{
+	const char *p = arg;
+	while(*p != '\0')
+	{
+		char *end;
+		unsigned long value = strtoul(p, &end, 10);
+		if(end == p || value == 0 || (*end != ',' && *end != '\0'))
+		{
+			printf("Error: Invalid %s list %s\n", name, arg);
+			exit(EXIT_FAILURE);
+		}
+		values.push_back(value);
+		p = (*end == ',') ? end + 1 : end;
+	}
+	if(values.empty())
+	{
+		printf("Error: Invalid %s list %s\n", name, arg);
+		exit(EXIT_FAILURE);
+	}
+}
+
+//runs every combination of the given sizes on the trace
+//prints a CSV header and then one row per configuration
+void run_sweep(vector<unsigned long>& rob_sizes, vector<unsigned long>& iq_sizes, vector<unsigned long>& widths, trace_reader *trace, const char *trace_file, sim_options *opts)
+{
+	//read the trace once. a binary trace is already in memory (mapped)
+	uint64_t num_recs;
+	const trace_record *recs = trace->get_records(&num_recs);
+	vector<trace_record> loaded;
+	if(recs == NULL)
+	{
+		num_recs = load_trace(trace, loaded);
+		recs = loaded.empty() ? NULL : &loaded[0];
+	}
+
+	vector<sweep_point> points;
+	unsigned int num_valid = 0;
+	for(int r = 0; r < (int) rob_sizes.size(); r++)
+		for(int q = 0; q < (int) iq_sizes.size(); q++)
+			for(int w = 0; w < (int) widths.size(); w++)
+			{
+				sweep_point p;
+				p.params.rob_size = rob_sizes[r];
+				p.params.iq_size = iq_sizes[q];
+				p.params.width = widths[w];
+				p.instructions = 0;
+				p.cycles = 0;
+				//the same check for the pipeline and the --model estimate
+				p.valid = proc_params_valid(&p.params);
+				p.done = !p.valid;
+				if(p.valid)
+					num_valid++;
+				points.push_back(p);
+			}
+
+	unsigned int num_threads = opts->sweep_threads;
+	if(num_threads == 0)
+		num_threads = thread::hardware_concurrency();
+	if(num_threads == 0)
+		num_threads = 1;
+	if(num_threads > num_valid)
+		num_threads = num_valid;
+	if(num_threads == 0)
+		num_threads = 1;
+
+	printf("rob_size,iq_size,width,trace,instructions,cycles,ipc\n");
+	sweep_pool pool(recs, num_recs, opts, trace_file, &points, num_threads);
+	pool.run();
+}
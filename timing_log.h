@@ -0,0 +1,26 @@
+#ifndef TIMING_LOG_H
+#define TIMING_LOG_H
+
+#include <stdint.h>
+
+//binary per-instruction timing log (sim --timing-log <file>), read by tool/scope
+//an 8 byte magic followed by one fixed size record per retired instruction,
+//in retire order. the stages follow each other, so the cycle a stage starts
+//in is the fetch cycle plus the durations of all the stages before it
+#define TIMING_LOG_MAGIC "OOOTIM1"
+#define TIMING_LOG_STAGES 9
+
+typedef struct timing_log_record{
+	uint64_t sequence;
+	//cycle in which the instruction was fetched
+	uint64_t fetch_cycle;
+	//cycles spent in FE, DE, RN, RR, DI, IS, EX, WB and RT
+	//(the counters are 64 bit, but no stage ever takes 2^32 cycles)
+	uint32_t durations[TIMING_LOG_STAGES];
+	uint8_t op_type;
+	int8_t src1;
+	int8_t src2;
+	int8_t dst;
+}timing_log_record;
+
+#endif
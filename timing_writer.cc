@@ -0,0 +1,197 @@
+//output sink for the per-instruction timing log
+//printf is far too slow for one line per retired instruction, so the lines
+//are formatted by hand into a large buffer that is written out in one go.
+//the same sink also writes the binary timing log (timing_log.h)
+//with a writer thread, full buffers are handed over and written while the
+//simulation goes on (a fixed set of buffers keeps the memory bounded)
+//everything is allocated by writer_initialize, writing never allocates
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+//size of one output buffer
+#define TIMING_BUFFER_SIZE (1 << 20)
+//buffers in flight with a writer thread
+#define TIMING_NUM_BUFFERS 4
+//a line never gets longer than this (13 numbers of at most 20 digits plus text)
+#define TIMING_MAX_LINE 512
+
+class timing_writer
+{
+	private:
+		FILE *out;
+		bool async;
+
+        //buffer being filled
+		char *buf;
+		size_t used;
+
+        //writer thread: full buffers waiting to be written (oldest first) and
+        //empty buffers ready to be filled, both guarded by lock. neither ever
+        //holds more than all the buffers, which they have room for
+		std::thread *writer;
+		std::mutex lock;
+		std::condition_variable changed;
+		std::vector< std::pair<char *, size_t> > full;
+		std::vector<char *> empty;
+		bool stop;
+
+		std::vector<char *> all_buffers;
+
+		void writer_loop();
+
+        //writes out (or hands over) the current buffer and starts a new one
+		void swap_buffer();
+
+	public:
+        //with async, the buffers are written by a separate thread
+		void writer_initialize(FILE *out, bool async);
+
+        //called before every line, makes room for at least one full line
+		void begin_line(){
+            if(TIMING_BUFFER_SIZE - used < TIMING_MAX_LINE)
+                swap_buffer();
+        }
+
+		void put_char(char c){
+            buf[used++] = c;
+        }
+
+        //string without the terminating '\0'
+		void put_str(const char *s){
+            while(*s != '\0')
+                buf[used++] = *s++;
+        }
+
+		void put_uint(uint64_t value){
+            char digits[20];
+            int n = 0;
+            do{
+                digits[n++] = '0' + (value % 10);
+                value /= 10;
+            }while(value != 0);
+            while(n > 0)
+                buf[used++] = digits[--n];
+        }
+
+		void put_int(int64_t value){
+            if(value < 0)
+            {
+                buf[used++] = '-';
+                put_uint((uint64_t) 0 - (uint64_t) value);
+            }
+            else
+                put_uint(value);
+        }
+
+        //raw bytes, for the binary timing log (at most TIMING_MAX_LINE per line)
+		void put_bytes(const void *data, size_t size){
+            memcpy(buf + used, data, size);
+            used += size;
+        }
+
+        //writes out everything formatted so far
+		void flush();
+
+        //flushes, stops the writer thread and frees the buffers
+		void writer_close();
+};
+
+void timing_writer::writer_initialize(FILE *out, bool async)
+{
+	this->out = out;
+	this->async = async;
+	used = 0;
+	stop = false;
+	writer = NULL;
+	int num_buffers = async ? TIMING_NUM_BUFFERS : 1;
+	full.reserve(num_buffers);
+	empty.reserve(num_buffers);
+	for(int i = 0; i < num_buffers; i++)
+		all_buffers.push_back(new char[TIMING_BUFFER_SIZE]);
+	buf = all_buffers[0];
+	for(int i = 1; i < num_buffers; i++)
+		empty.push_back(all_buffers[i]);
+	if(async)
+		writer = new std::thread(&timing_writer::writer_loop, this);
+}
+
+void timing_writer::writer_loop()
+{
+	std::unique_lock<std::mutex> guard(lock);
+	while(true)
+	{
+		while(full.empty() && !stop)
+			changed.wait(guard);
+		if(full.empty())
+			return;
+		std::pair<char *, size_t> next = full.front();
+		full.erase(full.begin());
+		//write without holding the lock so the simulation can keep going
+		guard.unlock();
+		fwrite(next.first, 1, next.second, out);
+		guard.lock();
+		empty.push_back(next.first);
+		changed.notify_all();
+	}
+}
+
+void timing_writer::swap_buffer()
+{
+	if(used == 0)
+		return;
+	if(!async)
+	{
+		fwrite(buf, 1, used, out);
+		used = 0;
+		return;
+	}
+	std::unique_lock<std::mutex> guard(lock);
+	full.push_back(std::make_pair(buf, used));
+	changed.notify_all();
+	//all the buffers are in flight, wait for the writer to catch up
+	while(empty.empty())
+		changed.wait(guard);
+	buf = empty.back();
+	empty.pop_back();
+	used = 0;
+}
+
+void timing_writer::flush()
+{
+	swap_buffer();
+	if(async)
+	{
+		//wait until the writer thread wrote every full buffer
+		std::unique_lock<std::mutex> guard(lock);
+		while(!full.empty() || empty.size() + 1 < all_buffers.size())
+			changed.wait(guard);
+	}
+	fflush(out);
+}
+
+void timing_writer::writer_close()
+{
+	flush();
+	if(writer != NULL)
+	{
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			stop = true;
+		}
+		changed.notify_all();
+		writer->join();
+		delete writer;
+		writer = NULL;
+	}
+	for(int i = 0; i < (int) all_buffers.size(); i++)
+		delete [] all_buffers[i];
+	all_buffers.clear();
+	empty.clear();
+	buf = NULL;
+}
@@ -2,7 +2,9 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
+#include <string.h>
 #include "printline.h"
+#include "../timing_log.h"
 
 #define DIR_LENGTH	512
 
@@ -75,10 +77,29 @@ int main(int argc, char *argv[]) {
 
 	printline PL(fp_out);
 
-	char line[512];
-	while (fgets(line, 512, fp_in)) {
-	   if (line[0] != '#')	// comments are preceded by '#' in first character
-	      PL.print(line);
+	// The input is either the text output of sim or a binary timing log
+	// (sim --timing-log <file>), which starts with TIMING_LOG_MAGIC.
+	char magic[8];
+	if (fread(magic, 1, 8, fp_in) == 8 && memcmp(magic, TIMING_LOG_MAGIC, 8) == 0) {
+	   timing_log_record rec;
+	   stamp_t stamps[NUM_STAGES];
+	   while (fread(&rec, sizeof(rec), 1, fp_in) == 1) {
+	      uint64_t cycle = rec.fetch_cycle;
+	      for (int i = 0; i < NUM_STAGES; i++) {
+	         stamps[i].cycle = cycle;
+	         stamps[i].dur = rec.durations[i];
+	         cycle += rec.durations[i];
+	      }
+	      PL.print(rec.sequence, rec.op_type, rec.src1, rec.src2, rec.dst, stamps);
+	   }
+	}
+	else {
+	   rewind(fp_in);
+	   char line[512];
+	   while (fgets(line, 512, fp_in)) {
+	      if (line[0] != '#')	// comments are preceded by '#' in first character
+	         PL.print(line);
+	   }
 	}
 
 	fclose(fp_in);
@@ -1,4 +1,6 @@
 #include <stdio.h>
+#include <stdint.h>
+#include <inttypes.h>
 #include <assert.h>
 
 #define PRINT_HEADER	35
@@ -10,7 +12,7 @@ const char *stage_str[NUM_STAGES] = {"FE ", "DE ", "RN ", "RR ", "DI ", "IS ", "
 #define ADDMAX	50
 
 typedef struct {
-   unsigned int cycle;
+   uint64_t cycle;
    unsigned int dur;
 } stamp_t;
 
@@ -19,31 +21,31 @@ class printline {
 	private:
 		FILE *fp;
 		unsigned int lineno;
-		unsigned int min_cycle;
-		unsigned int max_cycle;
-		unsigned int base_cycle;
+		uint64_t min_cycle;
+		uint64_t max_cycle;
+		uint64_t base_cycle;
 
 		void print_header() {
 		   base_cycle = min_cycle;
 
 		   fprintf(fp, LEADING_SPACES);
-		   for (unsigned int i = min_cycle; i < max_cycle + ADDMAX; i++)
-		      fprintf(fp, "%d  ", i/1000);
+		   for (uint64_t i = min_cycle; i < max_cycle + ADDMAX; i++)
+		      fprintf(fp, "%" PRIu64 "  ", i/1000);
 		   fprintf(fp, "\n");
 
 		   fprintf(fp, LEADING_SPACES);
-		   for (unsigned int i = min_cycle; i < max_cycle + ADDMAX; i++)
-		      fprintf(fp, "%d  ", i/100 - ((i/1000) * 10));
+		   for (uint64_t i = min_cycle; i < max_cycle + ADDMAX; i++)
+		      fprintf(fp, "%" PRIu64 "  ", i/100 - ((i/1000) * 10));
 		   fprintf(fp, "\n");
 
 		   fprintf(fp, LEADING_SPACES);
-		   for (unsigned int i = min_cycle; i < max_cycle + ADDMAX; i++)
-		      fprintf(fp, "%d  ", i/10 - ((i/100) * 10));
+		   for (uint64_t i = min_cycle; i < max_cycle + ADDMAX; i++)
+		      fprintf(fp, "%" PRIu64 "  ", i/10 - ((i/100) * 10));
 		   fprintf(fp, "\n");
 
 		   fprintf(fp, LEADING_SPACES);
-		   for (unsigned int i = min_cycle; i < max_cycle + ADDMAX; i++)
-		      fprintf(fp, "%d  ", i - ((i/10) * 10));
+		   for (uint64_t i = min_cycle; i < max_cycle + ADDMAX; i++)
+		      fprintf(fp, "%" PRIu64 "  ", i - ((i/10) * 10));
 		   fprintf(fp, "\n");
 		}
 
@@ -69,18 +71,12 @@ class printline {
 		void print(char *line) {
 		   unsigned int scan;
 
-		   unsigned int seq_no;
+		   uint64_t seq_no;
 		   unsigned int fu_type;
 		   int src1, src2, dst;
 		   stamp_t stamps[NUM_STAGES];
 
-		   unsigned int i, j, cycle;
-
-		   // Print header every so often...
-		   if ((lineno % PRINT_HEADER) == 0)
-		      print_header();
-
-		   scan = sscanf(line, "%d fu{%d} src{%d,%d} dst{%d} FE{%d,%d} DE{%d,%d} RN{%d,%d} RR{%d,%d} DI{%d,%d} IS{%d,%d} EX{%d,%d} WB{%d,%d} RT{%d,%d}",
+		   scan = sscanf(line, "%" SCNu64 " fu{%u} src{%d,%d} dst{%d} FE{%" SCNu64 ",%u} DE{%" SCNu64 ",%u} RN{%" SCNu64 ",%u} RR{%" SCNu64 ",%u} DI{%" SCNu64 ",%u} IS{%" SCNu64 ",%u} EX{%" SCNu64 ",%u} WB{%" SCNu64 ",%u} RT{%" SCNu64 ",%u}",
 			&seq_no,
 			&fu_type,
 			&src1, &src2,
@@ -102,14 +98,27 @@ class printline {
 		      exit(-1);
 		   }
 
-		   fprintf(fp, "%8d fu{%d} src{%3d,%3d} dst{%3d}\t",
+		   print(seq_no, fu_type, src1, src2, dst, stamps);
+		}
+
+		// Same as above, for a record that is already parsed
+		// (binary timing log, see timing_log.h).
+		void print(uint64_t seq_no, unsigned int fu_type, int src1, int src2, int dst, stamp_t *stamps) {
+		   unsigned int i, j;
+		   uint64_t cycle, c;
+
+		   // Print header every so often...
+		   if ((lineno % PRINT_HEADER) == 0)
+		      print_header();
+
+		   fprintf(fp, "%8" PRIu64 " fu{%d} src{%3d,%3d} dst{%3d}\t",
 				seq_no, fu_type, src1, src2, dst);
 
 		   //////////////////////////////////////////////////////
 		   // Check consistency of cycle/duration information.
 		   //////////////////////////////////////////////////////
 		   if (stamps[0].cycle < min_cycle) {
-		      fprintf(stderr, "Line %d: `FE cycle (%d)' is inconsistent with (i.e., less than) previous fetch cycles, exiting...\n",
+		      fprintf(stderr, "Line %d: `FE cycle (%" PRIu64 ")' is inconsistent with (i.e., less than) previous fetch cycles, exiting...\n",
 			lineno, stamps[0].cycle);
 		      fprintf(stderr, "If you cannot determine the problem, contact `ericro@ncsu.edu'.\n");
 		      exit(-1);
@@ -120,7 +129,7 @@ class printline {
 
 		   for (i = 0; i < (NUM_STAGES - 1); i++) {
 		      if ((stamps[i].cycle + stamps[i].dur) != stamps[i+1].cycle) {
-		         fprintf(stderr, "Line %d: `%s cycle (%d)' is inconsistent with `%s cycle (%d)' and `%s duration (%d)', exiting...\n",
+		         fprintf(stderr, "Line %d: `%s cycle (%" PRIu64 ")' is inconsistent with `%s cycle (%" PRIu64 ")' and `%s duration (%d)', exiting...\n",
 			   lineno, stage_str[i+1], stamps[i+1].cycle, stage_str[i], stamps[i].cycle, stage_str[i], stamps[i].dur);
 		         fprintf(stderr, "If you cannot determine the problem, contact `ericro@ncsu.edu'.\n");
 		         exit(-1);
@@ -134,7 +143,7 @@ class printline {
 		   // Leading blank cycles.
 		   //////////////////////////
 		   assert(base_cycle <= stamps[0].cycle);
-		   for (i = base_cycle; i < stamps[0].cycle; i++)
+		   for (c = base_cycle; c < stamps[0].cycle; c++)
 		      fprintf(fp, BLANK_CYCLE);
 
 		   //////////////////////////
@@ -0,0 +1,35 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "trace_reader.cc"
+
+/*  converts a text trace into the binary trace format
+
+    Example:-
+    trace2bin proj3-traces/val_trace_gcc1
+        writes proj3-traces/val_trace_gcc1.bin, which sim then uses
+        automatically for proj3-traces/val_trace_gcc1 while it stays up to date
+    trace2bin gcc_trace.txt gcc.bin
+        writes gcc.bin, which can be given to sim directly as the trace file
+*/
+int main(int argc, char* argv[])
+{
+    if(argc != 2 && argc != 3)
+    {
+        printf("Usage: trace2bin <text_trace> [binary_trace]\n");
+        exit(EXIT_FAILURE);
+    }
+
+    char bin_file[4096];
+    if(argc == 3)
+        snprintf(bin_file, sizeof(bin_file), "%s", argv[2]);
+    else
+        binary_sidecar_name(argv[1], bin_file, sizeof(bin_file));
+
+    long num_records = convert_text_trace(argv[1], bin_file);
+    if(num_records < 0)
+        exit(EXIT_FAILURE);
+
+    printf("%s: %ld instructions\n", bin_file, num_records);
+    return 0;
+}
@@ -0,0 +1,570 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <inttypes.h>
+
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+//binary trace format
+//a header followed by fixed width records, one per instruction
+//the binary file is memory mapped, so reading an instruction is just a copy
+//text traces are converted by trace2bin into <trace>.bin next to the text file
+#define TRACE_MAGIC "OOOTRC1"
+
+typedef struct trace_header{
+	//TRACE_MAGIC including the terminating 0
+	char magic[8];
+	//number of records that follow the header
+	uint64_t num_records;
+}trace_header;
+
+//one instruction of the trace (16 bytes)
+//registers are 0..66 or -1 when not used, so they fit in a byte
+#define TRACE_MAX_REG 66
+typedef struct trace_record{
+	uint64_t pc;
+	int8_t op_type;
+	int8_t dst;
+	int8_t src1;
+	int8_t src2;
+	uint32_t reserved;
+}trace_record;
+
+//single producer / single consumer ring buffer of trace records
+//the trace reader thread parses ahead into the ring and fetch drains it
+//no locks: the producer only writes tail, the consumer only writes head
+//both sides keep a private copy of the other index and only reload it
+//when the ring looks full (producer) or empty (consumer)
+class trace_ring
+{
+	private:
+        //number of records the ring can hold (power of two)
+		uint64_t capacity;
+		std::vector<trace_record> buf;
+
+        //next record the consumer reads
+		std::atomic<uint64_t> head;
+        //next record the producer writes
+		std::atomic<uint64_t> tail;
+        //the producer reached the end of the trace
+		std::atomic<bool> done;
+        //the consumer is going away, the producer has to stop
+		std::atomic<bool> stop;
+        //line of the text trace that is out of range (0 = none), set before finish()
+		std::atomic<uint64_t> bad_line;
+
+        //private copies of the other side's index
+		uint64_t producer_head_cache;
+		uint64_t consumer_tail_cache;
+
+        //a side that spun for a while without progress sleeps here until the
+        //other side moves its index, finishes or asks to stop
+		std::mutex sleep_lock;
+		std::condition_variable wakeup;
+		std::atomic<bool> sleeping;
+		void wait_until(bool (trace_ring::*ready)());
+		void wake_other_side(bool force);
+		bool can_push(){
+            return tail.load(std::memory_order_seq_cst) - head.load(std::memory_order_seq_cst) != capacity || stop.load(std::memory_order_seq_cst);
+        }
+		bool can_pop(){
+            return head.load(std::memory_order_seq_cst) != tail.load(std::memory_order_seq_cst) || done.load(std::memory_order_seq_cst);
+        }
+
+	public:
+		trace_ring(uint64_t capacity_pow2) : capacity(capacity_pow2), buf(capacity_pow2), head(0), tail(0), done(false), stop(false), bad_line(0), producer_head_cache(0), consumer_tail_cache(0), sleeping(false) {}
+
+        //producer side. waits while the ring is full
+        //returns false if the consumer asked to stop
+		bool push(trace_record& rec);
+        //producer side. no more records will be pushed
+		void finish(){
+            done.store(true, std::memory_order_release);
+            wake_other_side(true);
+        }
+        //producer side. the trace stops at a line that is out of range
+		void finish_at_bad_line(uint64_t line){
+            bad_line.store(line, std::memory_order_relaxed);
+            finish();
+        }
+        //consumer side, once pop returned 0
+		uint64_t get_bad_line(){
+            return bad_line.load(std::memory_order_relaxed);
+        }
+		bool stop_requested(){
+            return stop.load(std::memory_order_relaxed);
+        }
+
+        //consumer side. pops up to max records, waits while the ring is empty
+        //returns 0 only once the producer finished and the ring is drained
+		unsigned int pop(trace_record *recs, unsigned int max);
+        //consumer side. tell the producer to stop
+		void request_stop(){
+            stop.store(true, std::memory_order_relaxed);
+            wake_other_side(true);
+        }
+};
+
+//yields before a side of the ring goes to sleep
+#define TRACE_RING_SPINS 64
+
+void trace_ring::wait_until(bool (trace_ring::*ready)())
+{
+	std::unique_lock<std::mutex> lock(sleep_lock);
+	sleeping.store(true, std::memory_order_seq_cst);
+	while(!(this->*ready)())
+		wakeup.wait(lock);
+	sleeping.store(false, std::memory_order_relaxed);
+}
+
+//called after an index, done or stop was stored. the fence orders that store
+//before the sleeping load, which pairs with the store/recheck in wait_until
+void trace_ring::wake_other_side(bool force)
+{
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if(!force && !sleeping.load(std::memory_order_relaxed))
+		return;
+	//taking the lock makes sure a side that has not slept yet sees the change
+	{
+		std::lock_guard<std::mutex> lock(sleep_lock);
+	}
+	wakeup.notify_all();
+}
+
+bool trace_ring::push(trace_record& rec)
+{
+	uint64_t t = tail.load(std::memory_order_relaxed);
+	unsigned int spins = 0;
+	while(t - producer_head_cache == capacity)
+	{
+		producer_head_cache = head.load(std::memory_order_acquire);
+		if(t - producer_head_cache == capacity)
+		{
+			if(stop_requested())
+				return false;
+			if(++spins < TRACE_RING_SPINS)
+				std::this_thread::yield();
+			else
+				wait_until(&trace_ring::can_push);
+		}
+	}
+	buf[t & (capacity - 1)] = rec;
+	tail.store(t + 1, std::memory_order_release);
+	wake_other_side(false);
+	return true;
+}
+
+unsigned int trace_ring::pop(trace_record *recs, unsigned int max)
+{
+	uint64_t h = head.load(std::memory_order_relaxed);
+	unsigned int spins = 0;
+	while(consumer_tail_cache == h)
+	{
+		//done has to be read before tail, so no record pushed before finish() is missed
+		bool finished = done.load(std::memory_order_acquire);
+		consumer_tail_cache = tail.load(std::memory_order_acquire);
+		if(consumer_tail_cache == h)
+		{
+			if(finished)
+				return 0;
+			if(++spins < TRACE_RING_SPINS)
+				std::this_thread::yield();
+			else
+				wait_until(&trace_ring::can_pop);
+		}
+	}
+	unsigned int n = 0;
+	while(n < max && h != consumer_tail_cache)
+	{
+		recs[n++] = buf[h & (capacity - 1)];
+		h++;
+	}
+	head.store(h, std::memory_order_release);
+	wake_other_side(false);
+	return n;
+}
+
+//records parsed ahead by the trace reader thread (16 bytes each, 1MB)
+#define TRACE_RING_RECORDS (1 << 16)
+
+//parses one line of a text trace
+//returns 1 for an instruction, 0 at the end of the trace and -1 for a line with
+//an op type or register the simulator does not model (op 0..2, registers -1 or
+//0..TRACE_MAX_REG). this is checked before the values are narrowed to a byte
+int parse_text_instr(FILE *fp, trace_record *rec)
+{
+	unsigned long pc;
+	int op_type, dst, src1, src2;
+	if(fscanf(fp, "%lx %d %d %d %d", &pc, &op_type, &dst, &src1, &src2) != 5)
+		return 0;
+	if(op_type < 0 || op_type > 2 || dst < -1 || dst > TRACE_MAX_REG || src1 < -1 || src1 > TRACE_MAX_REG || src2 < -1 || src2 > TRACE_MAX_REG)
+		return -1;
+	rec->pc = pc;
+	rec->op_type = op_type;
+	rec->dst = dst;
+	rec->src1 = src1;
+	rec->src2 = src2;
+	rec->reserved = 0;
+	return 1;
+}
+
+//body of the trace reader thread
+void trace_prefetch_thread(FILE *fp, trace_ring *ring)
+{
+	trace_record rec;
+	uint64_t line = 0;
+	while(!ring->stop_requested())
+	{
+		int parsed = parse_text_instr(fp, &rec);
+		line++;
+		if(parsed == -1)
+		{
+			ring->finish_at_bad_line(line);
+			return;
+		}
+		if(parsed == 0 || !ring->push(rec))
+			break;
+	}
+	ring->finish();
+}
+
+//reads instructions from a trace file
+//text traces are parsed line by line with fscanf, optionally on a separate
+//thread that runs ahead of the simulation (prefetch)
+//binary traces (or a fresh binary sidecar of a text trace) are memory mapped
+//the trace file "-" reads a text trace from stdin, so traces can be piped in
+//a trace already in memory can be read by any number of readers at once
+class trace_reader
+{
+	private:
+        //text trace
+		FILE *fp;
+        //lines parsed so far and the name of the trace, for the error message
+		uint64_t text_line;
+		char trace_name[4096];
+        //stops the run at a text trace line that is out of range
+		void bad_text_line(uint64_t line);
+
+        //text trace parsed by the trace reader thread
+		trace_ring *ring;
+		std::thread *prefetcher;
+
+        //binary trace (memory mapped or already in memory)
+		bool is_binary;
+		void *map_base;
+		size_t map_size;
+		const trace_record *records;
+		uint64_t num_records;
+		uint64_t next_record;
+
+        //maps a binary trace file, returns false if it is not a valid binary trace
+		bool map_binary(const char *bin_file);
+
+	public:
+        //opens the trace. with use_sidecar, <trace_file>.bin is used instead of
+        //the text file when it exists and is at least as new as the text file
+        //with prefetch, a text trace is parsed ahead on a separate thread
+        //returns false if the trace cannot be opened
+		bool trace_open(const char *trace_file, bool use_sidecar, bool prefetch);
+
+        //reads the trace from records that are already in memory
+        //the records are only read, so many readers can share them
+		void trace_open_records(const trace_record *recs, uint64_t count);
+
+        //reads the next instruction. returns false once the trace is depleted
+		bool read_instr(trace_record *rec){
+            return read_instrs(rec, 1) == 1;
+        }
+
+        //reads up to max instructions. returns fewer only once the trace is depleted
+		unsigned int read_instrs(trace_record *recs, unsigned int max);
+
+		void trace_close();
+
+        //true when the instructions come from a memory mapped binary trace
+		bool is_binary_trace(){
+            return is_binary;
+        }
+
+        //all the records of a binary trace, NULL for a text trace
+		const trace_record *get_records(uint64_t *count){
+            *count = num_records;
+            return is_binary ? records : NULL;
+        }
+};
+
+//name of the binary sidecar for a text trace
+void binary_sidecar_name(const char *trace_file, char *bin_file, size_t size)
+{
+	snprintf(bin_file, size, "%s.bin", trace_file);
+}
+
+//checks whether a file starts with the binary trace magic
+//only regular files are looked at, peeking into a pipe would eat its data
+bool file_is_binary_trace(const char *file)
+{
+	struct stat st;
+	if(stat(file, &st) != 0 || !S_ISREG(st.st_mode))
+		return false;
+
+	trace_header header;
+	FILE *fp = fopen(file, "rb");
+	if(fp == NULL)
+		return false;
+	bool is_bin = fread(&header, sizeof(header), 1, fp) == 1 && memcmp(header.magic, TRACE_MAGIC, sizeof(header.magic)) == 0;
+	fclose(fp);
+	return is_bin;
+}
+
+//checks whether the sidecar exists and was written after the last change of the text trace
+bool binary_sidecar_is_fresh(const char *trace_file, const char *bin_file)
+{
+	struct stat text_stat;
+	struct stat bin_stat;
+	if(stat(trace_file, &text_stat) != 0 || stat(bin_file, &bin_stat) != 0)
+		return false;
+	if(bin_stat.st_mtim.tv_sec != text_stat.st_mtim.tv_sec)
+		return bin_stat.st_mtim.tv_sec > text_stat.st_mtim.tv_sec;
+	return bin_stat.st_mtim.tv_nsec >= text_stat.st_mtim.tv_nsec;
+}
+
+bool trace_reader::map_binary(const char *bin_file)
+{
+	int fd = open(bin_file, O_RDONLY);
+	if(fd < 0)
+		return false;
+
+	struct stat st;
+	if(fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(trace_header))
+	{
+		close(fd);
+		return false;
+	}
+
+	void *base = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	//the mapping stays valid after the descriptor is closed
+	close(fd);
+	if(base == MAP_FAILED)
+		return false;
+
+	const trace_header *header = (const trace_header *) base;
+	if(memcmp(header->magic, TRACE_MAGIC, sizeof(header->magic)) != 0 ||
+	   sizeof(trace_header) + header->num_records * sizeof(trace_record) > (size_t) st.st_size)
+	{
+		munmap(base, st.st_size);
+		return false;
+	}
+	//the records are read front to back exactly once
+	madvise(base, st.st_size, MADV_SEQUENTIAL);
+
+	map_base = base;
+	map_size = st.st_size;
+	records = (const trace_record *) ((const char *) base + sizeof(trace_header));
+	num_records = header->num_records;
+	next_record = 0;
+	is_binary = true;
+	return true;
+}
+
+bool trace_reader::trace_open(const char *trace_file, bool use_sidecar, bool prefetch)
+{
+	fp = NULL;
+	text_line = 0;
+	snprintf(trace_name, sizeof(trace_name), "%s", trace_file);
+	ring = NULL;
+	prefetcher = NULL;
+	is_binary = false;
+	map_base = NULL;
+	map_size = 0;
+	records = NULL;
+	num_records = 0;
+	next_record = 0;
+
+	//the trace itself can be a binary trace
+	if(file_is_binary_trace(trace_file))
+		return map_binary(trace_file);
+
+	//a text trace with an up to date binary sidecar
+	if(use_sidecar)
+	{
+		char bin_file[4096];
+		binary_sidecar_name(trace_file, bin_file, sizeof(bin_file));
+		if(binary_sidecar_is_fresh(trace_file, bin_file) && map_binary(bin_file))
+			return true;
+	}
+
+	if(strcmp(trace_file, "-") == 0)
+		fp = stdin;
+	else
+		fp = fopen(trace_file, "r");
+	if(fp == NULL)
+		return false;
+
+	if(prefetch)
+	{
+		ring = new trace_ring(TRACE_RING_RECORDS);
+		prefetcher = new std::thread(trace_prefetch_thread, fp, ring);
+	}
+	return true;
+}
+
+void trace_reader::trace_open_records(const trace_record *recs, uint64_t count)
+{
+	fp = NULL;
+	text_line = 0;
+	trace_name[0] = '\0';
+	ring = NULL;
+	prefetcher = NULL;
+	map_base = NULL;
+	map_size = 0;
+	records = recs;
+	num_records = count;
+	next_record = 0;
+	is_binary = true;
+}
+
+unsigned int trace_reader::read_instrs(trace_record *recs, unsigned int max)
+{
+	unsigned int n = 0;
+	if(is_binary)
+	{
+		while(n < max && next_record != num_records)
+			recs[n++] = records[next_record++];
+		return n;
+	}
+
+	if(ring != NULL)
+	{
+		//the ring hands out whatever is parsed, keep going till max or the end
+		while(n < max)
+		{
+			unsigned int got = ring->pop(recs + n, max - n);
+			if(got == 0)
+			{
+				if(ring->get_bad_line() != 0)
+					bad_text_line(ring->get_bad_line());
+				break;
+			}
+			n += got;
+		}
+		return n;
+	}
+
+	while(n < max)
+	{
+		int parsed = parse_text_instr(fp, &recs[n]);
+		if(parsed == 0)
+			break;
+		text_line++;
+		if(parsed == -1)
+			bad_text_line(text_line);
+		n++;
+	}
+	return n;
+}
+
+void trace_reader::bad_text_line(uint64_t line)
+{
+	printf("Error: %s line %" PRIu64 " is out of range\n", trace_name, line);
+	exit(EXIT_FAILURE);
+}
+
+void trace_reader::trace_close()
+{
+	//stop the trace reader thread before its file goes away
+	if(prefetcher != NULL)
+	{
+		ring->request_stop();
+		prefetcher->join();
+		delete prefetcher;
+		delete ring;
+		prefetcher = NULL;
+		ring = NULL;
+	}
+	if(fp != NULL && fp != stdin)
+		fclose(fp);
+	if(map_base != NULL)
+		munmap(map_base, map_size);
+	fp = NULL;
+	map_base = NULL;
+}
+
+//reads the rest of a trace into memory
+//returns the number of records read
+uint64_t load_trace(trace_reader *trace, std::vector<trace_record>& recs)
+{
+	trace_record chunk[1024];
+	unsigned int n;
+	while((n = trace->read_instrs(chunk, 1024)) != 0)
+		recs.insert(recs.end(), chunk, chunk + n);
+	return recs.size();
+}
+
+//converts a text trace into the binary format
+//the output is written to a temporary file first and renamed at the end so a
+//half written sidecar is never picked up by the simulator
+//returns the number of records written, or -1 on error (reason printed)
+long convert_text_trace(const char *text_file, const char *bin_file)
+{
+	FILE *in = fopen(text_file, "r");
+	if(in == NULL)
+	{
+		printf("Error: Unable to open file %s\n", text_file);
+		return -1;
+	}
+
+	char tmp_file[4096];
+	snprintf(tmp_file, sizeof(tmp_file), "%s.tmp", bin_file);
+	FILE *out = fopen(tmp_file, "wb");
+	if(out == NULL)
+	{
+		printf("Error: Unable to create file %s\n", tmp_file);
+		fclose(in);
+		return -1;
+	}
+
+	//the count is filled in once all the records are written
+	trace_header header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, TRACE_MAGIC, sizeof(header.magic));
+	fwrite(&header, sizeof(header), 1, out);
+
+	long line = 0;
+	trace_record rec;
+	int parsed;
+	while((parsed = parse_text_instr(in, &rec)) != 0)
+	{
+		line++;
+		if(parsed == -1)
+		{
+			printf("Error: %s line %ld is out of range\n", text_file, line);
+			fclose(in);
+			fclose(out);
+			remove(tmp_file);
+			return -1;
+		}
+		fwrite(&rec, sizeof(rec), 1, out);
+	}
+	fclose(in);
+
+	header.num_records = line;
+	fseek(out, 0, SEEK_SET);
+	fwrite(&header, sizeof(header), 1, out);
+	if(fclose(out) != 0 || rename(tmp_file, bin_file) != 0)
+	{
+		printf("Error: Unable to write file %s\n", bin_file);
+		remove(tmp_file);
+		return -1;
+	}
+	return line;
+}